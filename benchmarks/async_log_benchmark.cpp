@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include "Blackboard/blackboard_async_log.h"
+
+// Latency of a simulated tick (10 set() per tick) when the changes are persisted
+// synchronously (BlackboardWal, one write + fdatasync per tick) or asynchronously
+// (BlackboardAsyncLog).
+
+using Clock = std::chrono::steady_clock;
+
+static const int TICKS = 2000;
+static const int SETS_PER_TICK = 10;
+
+static void removeFiles(const std::string& filename)
+{
+    std::remove( (filename + ".log").c_str() );
+    std::remove( (filename + ".snapshot").c_str() );
+}
+
+template <typename Backend, typename EndOfTick>
+static std::vector<double> runTicks(Backend& bb, EndOfTick end_of_tick)
+{
+    std::vector<double> latencies;
+    latencies.reserve(TICKS);
+    for (int tick=0; tick<TICKS; tick++)
+    {
+        auto start = Clock::now();
+        for (int i=0; i<SETS_PER_TICK; i++){
+            bb.set( "key_" + std::to_string(i), SafeAny::Any( double(tick) ) );
+        }
+        end_of_tick();
+        latencies.push_back( std::chrono::duration<double, std::micro>( Clock::now() - start ).count() );
+        std::this_thread::sleep_for( std::chrono::microseconds(500) );
+    }
+    return latencies;
+}
+
+static void report(const char* name, std::vector<double> latencies)
+{
+    std::sort( latencies.begin(), latencies.end() );
+    auto percentile = [&](double p) {
+        return latencies[ std::min( latencies.size()-1, size_t(p * latencies.size()) ) ];
+    };
+    printf("%-28s p50 %9.1f us   p99 %9.1f us   p99.9 %9.1f us\n",
+           name, percentile(0.5), percentile(0.99), percentile(0.999) );
+}
+
+int main()
+{
+    const std::string filename("/tmp/blackboard_async_benchmark");
+    removeFiles(filename);
+    {
+        BlackboardWal bb(filename, false);
+        report("sync  (write + fdatasync)", runTicks(bb, [&bb](){ bb.sync(); }) );
+    }
+    removeFiles(filename);
+
+    for(bool use_io_uring: {false, true})
+    {
+        BlackboardAsyncLog bb(filename, 1024*1024, use_io_uring);
+        auto latencies = runTicks(bb, [](){});
+        report( bb.usingIoUring() ? "async (io_uring)" : "async (thread)", latencies );
+        removeFiles(filename);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "Blackboard/blackboard_concurrent.h"
+
+// Nodes reading 10 keys per tick from BlackboardConcurrent, while another
+// thread updates them: one get() per key (one virtual call and one lock each)
+// versus a single getMany().
+
+using Clock = std::chrono::steady_clock;
+
+static const std::array<std::string, 10> keys = { {
+    "pose_x", "pose_y", "pose_theta", "vel_x", "vel_y",
+    "vel_theta", "stamp", "battery", "mode", "goal_id" } };
+
+static void readSingle(Blackboard& bb, double* v)
+{
+    for (std::size_t k=0; k<keys.size(); k++) {
+        bb.get( keys[k], v[k] );
+    }
+}
+
+static void readBatch(Blackboard& bb, double* v)
+{
+    bb.getMany( keys, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9] );
+}
+
+template <typename Read>
+static double benchmark(std::size_t shards, int readers, int iterations, Read read)
+{
+    Blackboard bb( std::unique_ptr<BlackboardConcurrent>( new BlackboardConcurrent(shards) ) );
+    for (std::size_t i=0; i<keys.size(); i++) {
+        bb.set( keys[i], double(i) );
+    }
+
+    std::atomic<bool> done(false);
+    std::thread writer( [&]()
+    {
+        double value = 0;
+        while( !done ) {
+            bb.setMany( keys, value, value, value, value, value,
+                        value, value, value, value, value );
+            value += 1.0;
+        }
+    } );
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t=0; t<readers; t++)
+    {
+        threads.emplace_back( [&]()
+        {
+            double v[10];
+            double sum = 0;
+            for (int i=0; i<iterations; i++)
+            {
+                read(bb, v);
+                sum += v[9];
+            }
+            if( sum < 0 ) { printf("%f\n", sum); } // keep the result alive
+        } );
+    }
+    for (auto& th: threads) { th.join(); }
+    const double ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    done = true;
+    writer.join();
+    return ns / (double(iterations) * readers);
+}
+
+int main()
+{
+    const int iterations = 200000;
+    const int readers = std::max( 1u, std::thread::hardware_concurrency() - 1 );
+    printf("%d reader threads, 1 writer\n", readers);
+
+    for (std::size_t shards: {1, 16})
+    {
+        printf("%2d shards: 10 x get(): %7.1f ns/tick   getMany(): %7.1f ns/tick\n", int(shards),
+               benchmark(shards, readers, iterations, readSingle),
+               benchmark(shards, readers, iterations, readBatch) );
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "Blackboard/blackboard_local.h"
+
+// Failed conversion (int 300 -> uint8_t) and, for reference, a successful one.
+//
+// "get":    Blackboard::get() throws and the caller catches the exception.
+// "tryGet": Blackboard::tryGet() returns SafeAny::ConversionError::TooLarge.
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Func>
+static double nsPerCall(int iterations, Func func)
+{
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++) { func(); }
+    return std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / iterations;
+}
+
+int main()
+{
+    Blackboard bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal ) );
+    bb.set("large", 300);
+    bb.set("small", 100);
+
+    const int iterations = 200000;
+    uint8_t value = 0;
+    int failures = 0;
+
+    const double get_fail = nsPerCall( iterations, [&]()
+    {
+        try { bb.get("large", value); }
+        catch (std::runtime_error&) { failures++; }
+    });
+    const double try_fail = nsPerCall( iterations, [&]()
+    {
+        if( bb.tryGet("large", value) != SafeAny::ConversionError::Ok ) { failures++; }
+    });
+    const double get_ok = nsPerCall( iterations, [&]() { bb.get("small", value); } );
+    const double try_ok = nsPerCall( iterations, [&]() { bb.tryGet("small", value); } );
+
+    printf("failure:  get %7.1f ns  tryGet %7.1f ns\n", get_fail, try_fail);
+    printf("success:  get %7.1f ns  tryGet %7.1f ns\n", get_ok, try_ok);
+    printf("(%d failures, %d)\n", failures, int(value));
+    return 0;
+}
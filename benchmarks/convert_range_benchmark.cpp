@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+// 512 numbers (joint states) converted into a std::vector<double> or <float>:
+// convertTo() one value at a time versus SafeAny::convertRange().
+
+using Clock = std::chrono::steady_clock;
+using SafeAny::Any;
+
+template <typename DST>
+static void benchmark(const char* name, const std::vector<Any>& values)
+{
+    std::vector<DST> out( values.size() );
+    const int iterations = 20000;
+    std::size_t failures = 0;
+
+    auto start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (std::size_t i=0; i<values.size(); i++)
+        {
+            failures += values[i].tryConvert( out[i] ) != SafeAny::ConversionError::Ok;
+        }
+    }
+    const double scalar_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        failures += SafeAny::convertRange( values.data(), values.data() + values.size(), out.data() );
+    }
+    const double range_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    const double count = double(iterations) * values.size();
+    printf("%-22s scalar %5.2f ns/value  convertRange %5.2f ns/value  (%zu failures)\n",
+           name, scalar_ns / count, range_ns / count, failures);
+}
+
+int main()
+{
+    std::vector<Any> doubles, mixed;
+    for (int i=0; i<512; i++)
+    {
+        doubles.push_back( Any( double(i) * 0.25 ) );
+        switch( i % 4 )
+        {
+        case 0: mixed.push_back( Any( double(i) * 0.25 ) ); break;
+        case 1: mixed.push_back( Any( float(i) * 0.5f ) ); break;
+        case 2: mixed.push_back( Any( int32_t(i) ) ); break;
+        case 3: mixed.push_back( Any( uint16_t(i) ) ); break;
+        }
+    }
+    benchmark<double>("double -> double", doubles);
+    benchmark<double>("mixed -> double", mixed);
+    benchmark<float>("double -> float", doubles);
+    benchmark<float>("mixed -> float", mixed);
+    benchmark<int32_t>("mixed -> int32 (fail)", mixed);
+    return 0;
+}
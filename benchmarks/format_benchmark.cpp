@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+// Numbers converted to text, as done by a logger for every entry of the blackboard:
+// std::to_string() versus Any::convert<std::string>() and SafeAny::formatNumber()
+// into a local buffer.
+
+using Clock = std::chrono::steady_clock;
+using SafeAny::Any;
+
+template <typename T>
+static void benchmark(const char* name, const std::vector<T>& numbers)
+{
+    std::vector<Any> values( numbers.begin(), numbers.end() );
+    const int iterations = 200;
+    std::size_t chars = 0;
+
+    auto start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const T& number: numbers) { chars += std::to_string( number ).size(); }
+    }
+    const double to_string_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    std::string str;
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const Any& value: values)
+        {
+            value.tryConvert( str );
+            chars += str.size();
+        }
+    }
+    const double convert_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    char buffer[SafeAny::NUMBER_BUFFER_SIZE];
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const T& number: numbers) { chars += SafeAny::formatNumber( buffer, number ) - buffer; }
+    }
+    const double format_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    const double count = double(iterations) * numbers.size();
+    printf("%-8s std::to_string %6.1f ns  convert<string> %6.1f ns  formatNumber %6.1f ns  (%zu chars)\n",
+           name, to_string_ns / count, convert_ns / count, format_ns / count, chars);
+}
+
+int main()
+{
+    std::vector<int32_t> ints;
+    std::vector<double> doubles;
+    std::vector<float> floats;
+    uint64_t state = 88172645463325252ULL;
+    for (int i=0; i<10000; i++)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        ints.push_back( int32_t(state) >> (state % 24) );
+        doubles.push_back( double(state % 2000000) / 1024.0 - 1000.0 );
+        floats.push_back( float(state % 100000) * 0.01f );
+    }
+    benchmark("int32", ints);
+    benchmark("double", doubles);
+    benchmark("float", floats);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Blackboard/blackboard_local.h"
+
+// get() through the type-erased Blackboard (virtual call to BlackboardImpl)
+// versus BasicBlackboard<BlackboardLocal> (backend known at compile time).
+// The values are int32_t read as double, with and without the conversion cache
+// of BlackboardLocal.
+
+using Clock = std::chrono::steady_clock;
+
+template <typename BB>
+static double benchmarkGet(BB& bb, const std::vector<std::string>& keys, int iterations)
+{
+    double sum = 0;
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        for(const auto& key: keys)
+        {
+            double value = 0;
+            bb.get(key, value);
+            sum += value;
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+    if( sum < 0 ) { printf("%f\n", sum); } // keep the result alive
+    return ns / (double(iterations) * keys.size());
+}
+
+template <typename BB>
+static void fill(BB& bb, const std::vector<std::string>& keys)
+{
+    for (std::size_t i=0; i<keys.size(); i++) {
+        bb.set( keys[i], int32_t(i) );
+    }
+}
+
+int main()
+{
+    std::vector<std::string> keys;
+    for (int i=0; i<100; i++) {
+        keys.push_back( "key_" + std::to_string(i) );
+    }
+    const int iterations = 20000;
+
+    Blackboard dynamic_bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal ) );
+    BasicBlackboard<BlackboardLocal> static_bb;
+    fill(dynamic_bb, keys);
+    fill(static_bb, keys);
+
+    printf("Blackboard (virtual):              %6.1f ns/get\n", benchmarkGet(dynamic_bb, keys, iterations) );
+    printf("BasicBlackboard<BlackboardLocal>:  %6.1f ns/get\n", benchmarkGet(static_bb, keys, iterations) );
+
+    std::unique_ptr<BlackboardLocal> cached_local( new BlackboardLocal );
+    cached_local->setConversionCache(true);
+    Blackboard cached_dynamic_bb( std::move(cached_local) );
+    BasicBlackboard<BlackboardLocal> cached_static_bb;
+    cached_static_bb.implementation().setConversionCache(true);
+    fill(cached_dynamic_bb, keys);
+    fill(cached_static_bb, keys);
+
+    printf("Blackboard, conversion cache:      %6.1f ns/get\n", benchmarkGet(cached_dynamic_bb, keys, iterations) );
+    printf("BasicBlackboard, conversion cache: %6.1f ns/get\n", benchmarkGet(cached_static_bb, keys, iterations) );
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/allocation_monitor.h"
+
+// Repeated set() of a std::vector<double>(1000): heap allocations and time per call.
+//
+// "before": the value is replaced, as BlackboardLocal used to do with storage_[key] = value.
+// "after":  the current BlackboardLocal, which assigns the vector in place.
+
+BLACKBOARD_ALLOCATION_MONITOR_HOOKS
+
+using Clock = std::chrono::steady_clock;
+
+class ReplacingLocal: public BlackboardImpl
+{
+public:
+    virtual const SafeAny::Any* get(const std::string& key) const override
+    {
+        auto it = storage_.find(key);
+        return ( it == storage_.end() ) ? nullptr : &(it->second);
+    }
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override
+    {
+        storage_[key] = value;
+    }
+
+private:
+    std::unordered_map<std::string, SafeAny::Any> storage_;
+};
+
+static void benchmark(const char* name, std::unique_ptr<BlackboardImpl> backend)
+{
+    Blackboard bb( std::move(backend) );
+    std::vector<double> vect(1000, 1.0);
+    bb.set("vect", vect);
+
+    const int iterations = 100000;
+    const std::size_t allocations = AllocationMonitor::allocations();
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        vect[i % vect.size()] = i;
+        bb.set("vect", vect);
+    }
+    const double ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    printf("%s %5.2f allocations/set  %7.1f ns/set\n", name,
+           double(AllocationMonitor::allocations() - allocations) / iterations, ns / iterations);
+}
+
+int main()
+{
+    benchmark("before:", std::unique_ptr<BlackboardImpl>( new ReplacingLocal ) );
+    benchmark("after: ", std::unique_ptr<BlackboardImpl>( new BlackboardLocal ) );
+    return 0;
+}
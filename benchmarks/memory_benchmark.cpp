@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/stat.h>
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_concurrent.h"
+#include "Blackboard/blackboard_variant.h"
+#include "Blackboard/blackboard_compact.h"
+#include "Blackboard/blackboard_image.h"
+#include "Blackboard/blackboard_shm.h"
+
+// Bytes per entry of each backend, for a board of small numeric entries
+// (the cells of a map: "cell_<i>" -> float).
+//
+// The heap is measured by the replacements of operator new/delete below: bytes
+// requested by the backend (the overhead of malloc, 8-16 bytes per block, is
+// excluded) and number of blocks. BlackboardImage and BlackboardShm are measured
+// by the size of their file / segment.
+
+static std::size_t heap_bytes = 0;
+static std::size_t heap_blocks = 0;
+
+void* operator new(std::size_t size)
+{
+    std::size_t* block = static_cast<std::size_t*>( std::malloc( size + 16 ) );
+    if( !block ) { throw std::bad_alloc(); }
+    block[0] = size;
+    heap_bytes += size;
+    heap_blocks++;
+    return reinterpret_cast<char*>(block) + 16;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if( !ptr ) { return; }
+    std::size_t* block = reinterpret_cast<std::size_t*>( static_cast<char*>(ptr) - 16 );
+    heap_bytes -= block[0];
+    heap_blocks--;
+    std::free( block );
+}
+
+static const int COUNT = 1000000;
+
+static std::string key(int i) { return "cell_" + std::to_string(i); }
+
+static void report(const char* name, double bytes, double blocks)
+{
+    printf("%-36s %7.1f bytes/entry  %5.2f heap blocks/entry\n", name, bytes / COUNT, blocks / COUNT);
+}
+
+template <typename Backend, typename... Args>
+static void measureHeap(const char* name, Args&&... args)
+{
+    const std::size_t bytes_before = heap_bytes;
+    const std::size_t blocks_before = heap_blocks;
+    {
+        std::unique_ptr<Backend> backend( new Backend( std::forward<Args>(args)... ) );
+        Blackboard bb( std::move(backend) );
+        for (int i=0; i<COUNT; i++) {
+            bb.set( key(i), float(i) );
+        }
+        report( name, double(heap_bytes - bytes_before), double(heap_blocks - blocks_before) );
+    }
+}
+
+static std::size_t fileSize(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+}
+
+int main()
+{
+    printf("%d entries, keys of %zu bytes, float values\n"
+           "sizeof: SafeAny::Any %zu, linb::any %zu, CompactAny %zu\n\n",
+           COUNT, key(COUNT/2).size(), sizeof(SafeAny::Any), sizeof(linb::any), sizeof(SafeAny::CompactAny));
+
+    measureHeap<BlackboardLocal>("BlackboardLocal");
+    {
+        linb::arena_resource arena( 1 << 20 );
+        measureHeap<BlackboardLocal>("BlackboardLocal (arena_resource)", &arena);
+    }
+    measureHeap<BlackboardConcurrent>("BlackboardConcurrent");
+    measureHeap< BlackboardVariant<float, double, int32_t, std::string> >("BlackboardVariant");
+    measureHeap<BlackboardCompact>("BlackboardCompact");
+
+    {
+        const char* filename = "memory_benchmark.img";
+        BlackboardImageWriter writer;
+        for (int i=0; i<COUNT; i++) {
+            writer.set( key(i), float(i) );
+        }
+        writer.save( filename );
+        report( "BlackboardImage (file)", double( fileSize(filename) ), 0 );
+        std::remove( filename );
+    }
+    {
+        const char* name = "/bb_memory_benchmark";
+        BlackboardShm::remove( name );
+        {
+            Blackboard bb( std::unique_ptr<BlackboardShm>( new BlackboardShm( name, COUNT, 0 ) ) );
+            for (int i=0; i<COUNT; i++) {
+                bb.set( key(i), float(i) );
+            }
+        }
+        report( "BlackboardShm (segment)", double( fileSize( (std::string("/dev/shm") + name).c_str() ) ), 0 );
+        BlackboardShm::remove( name );
+    }
+    return 0;
+}
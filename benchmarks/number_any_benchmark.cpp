@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+// Numbers set, read and converted through:
+//  - NumberAny: tag + payload, switch-based conversion.
+//  - SafeAny::Any, which stores its numbers in a NumberAny.
+//  - linb::any, the storage used by SafeAny::Any for all the values before NumberAny
+//    (vtable calls, type ids, any_cast).
+
+using Clock = std::chrono::steady_clock;
+using SafeAny::Any;
+using SafeAny::NumberAny;
+using SafeAny::ConversionError;
+
+// The conversion done by SafeAny::Any when it stored the numbers in a linb::any.
+template <typename DST>
+static ConversionError convertLinb(const linb::any& any, DST& dst)
+{
+    typedef linb::detail::type_registry TR;
+    using SafeAny::details::convert_number;
+    switch( any.type_id() )
+    {
+    case TR::id_int32:  return convert_number( *linb::any_cast<int32_t>(&any), dst );
+    case TR::id_uint8:  return convert_number( *linb::any_cast<uint8_t>(&any), dst );
+    case TR::id_float:  return convert_number( *linb::any_cast<float>(&any), dst );
+    case TR::id_double: return convert_number( *linb::any_cast<double>(&any), dst );
+    default:            return ConversionError::TypeMismatch;
+    }
+}
+
+template <typename Function>
+static double measure(int iterations, Function function)
+{
+    const auto start = Clock::now();
+    for (int n=0; n<iterations; n++) { function(n); }
+    return std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / iterations;
+}
+
+int main()
+{
+    const int iterations = 10000000;
+    const std::size_t size = 64;
+
+    std::vector<NumberAny> numbers( size );
+    std::vector<Any> anys( size );
+    std::vector<linb::any> linbs( size );
+    double sum = 0;
+
+    printf("%-10s %10s %10s %10s\n", "", "NumberAny", "Any", "linb::any");
+
+    // set: a new value of the same type
+    const double set_number = measure( iterations, [&](int n){ numbers[n % size] = NumberAny( int32_t(n) ); } );
+    const double set_any    = measure( iterations, [&](int n){ anys[n % size] = int32_t(n); } );
+    const double set_linb   = measure( iterations, [&](int n){ linbs[n % size] = int32_t(n); } );
+    printf("%-10s %8.2fns %8.2fns %8.2fns\n", "set", set_number, set_any, set_linb);
+
+    // get: read with the stored type
+    const double get_number = measure( iterations, [&](int n){ sum += *numbers[n % size].get<int32_t>(); } );
+    const double get_any    = measure( iterations, [&](int n){ sum += *anys[n % size].extractPtr<int32_t>(); } );
+    const double get_linb   = measure( iterations, [&](int n){ sum += *linb::any_cast<int32_t>( &linbs[n % size] ); } );
+    printf("%-10s %8.2fns %8.2fns %8.2fns\n", "get", get_number, get_any, get_linb);
+
+    // convert: int32_t to double and to uint8_t (checked)
+    const double conv_number = measure( iterations, [&](int n){
+        double d = 0; uint8_t u = 0;
+        numbers[n % size].tryConvert(d); numbers[n % size].tryConvert(u);
+        sum += d + u; } );
+    const double conv_any = measure( iterations, [&](int n){
+        double d = 0; uint8_t u = 0;
+        anys[n % size].tryConvert(d); anys[n % size].tryConvert(u);
+        sum += d + u; } );
+    const double conv_linb = measure( iterations, [&](int n){
+        double d = 0; uint8_t u = 0;
+        convertLinb( linbs[n % size], d ); convertLinb( linbs[n % size], u );
+        sum += d + u; } );
+    printf("%-10s %8.2fns %8.2fns %8.2fns\n", "convert", conv_number, conv_any, conv_linb);
+
+    // copy of a whole array
+    std::vector<NumberAny> numbers_copy( size );
+    std::vector<Any> anys_copy( size );
+    std::vector<linb::any> linbs_copy( size );
+    const double copy_number = measure( iterations / 64, [&](int){ numbers_copy = numbers; } ) / size;
+    const double copy_any    = measure( iterations / 64, [&](int){ anys_copy = anys; } ) / size;
+    const double copy_linb   = measure( iterations / 64, [&](int){ linbs_copy = linbs; } ) / size;
+    printf("%-10s %8.2fns %8.2fns %8.2fns\n", "copy", copy_number, copy_any, copy_linb);
+
+    printf("\nsizeof: NumberAny %zu, Any %zu, linb::any %zu  (checksum %g)\n",
+           sizeof(NumberAny), sizeof(Any), sizeof(linb::any), sum);
+    return 0;
+}
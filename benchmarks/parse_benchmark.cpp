@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+// Parameters stored as strings and read as double: std::stod() and std::istringstream
+// versus SafeAny::parseNumber() and Any::tryParse(), whose result is cached in the value.
+
+using Clock = std::chrono::steady_clock;
+using SafeAny::Any;
+
+int main()
+{
+    std::vector<std::string> texts;
+    uint64_t state = 88172645463325252ULL;
+    for (int i=0; i<1000; i++)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        char buffer[SafeAny::NUMBER_BUFFER_SIZE];
+        const double number = double(state % 2000000) / 1024.0 - 1000.0;
+        texts.push_back( std::string( buffer, SafeAny::formatNumber( buffer, number ) ) );
+    }
+    std::vector<Any> values( texts.begin(), texts.end() );
+
+    const int iterations = 500;
+    const double count = double(iterations) * texts.size();
+    double sum = 0;
+
+    auto start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const std::string& text: texts) { sum += std::stod( text ); }
+    }
+    printf("std::stod            %6.1f ns\n",
+           std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / count);
+
+    start = Clock::now();
+    for (int n=0; n<iterations / 10; n++)
+    {
+        for (const std::string& text: texts)
+        {
+            std::istringstream stream( text );
+            double value = 0;
+            stream >> value;
+            sum += value;
+        }
+    }
+    printf("std::istringstream   %6.1f ns\n",
+           std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / (count / 10));
+
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const std::string& text: texts)
+        {
+            double value = 0;
+            SafeAny::parseNumber( text.data(), text.data() + text.size(), value );
+            sum += value;
+        }
+    }
+    printf("parseNumber          %6.1f ns\n",
+           std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / count);
+
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        for (const Any& any: values)
+        {
+            double value = 0;
+            any.tryParse( value );
+            sum += value;
+        }
+    }
+    printf("Any::tryParse cached %6.1f ns   (%g)\n",
+           std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / count, sum);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Blackboard/blackboard_concurrent.h"
+
+// Copy of a board with 1000 entries, each one a 10 KB std::vector<uint8_t>,
+// and get() of one of them from BlackboardConcurrent (which copies the Any).
+//
+// "deep":   plain values, copied element by element.
+// "shared": values stored with SafeAny::Any::makeShared(), copied by reference.
+
+using Clock = std::chrono::steady_clock;
+
+typedef std::unordered_map<std::string, SafeAny::Any> Board;
+
+static Board makeBoard(bool shared)
+{
+    Board board;
+    for (int i=0; i<1000; i++)
+    {
+        std::vector<uint8_t> payload(10*1024, uint8_t(i));
+        board["entry_" + std::to_string(i)] = shared ? SafeAny::Any::makeShared( std::move(payload) ) :
+                                                       SafeAny::Any( std::move(payload) );
+    }
+    return board;
+}
+
+static void benchmark(const char* name, bool shared)
+{
+    const Board board = makeBoard(shared);
+
+    const int copies = 200;
+    std::size_t check = 0;
+    auto start = Clock::now();
+    for (int i=0; i<copies; i++)
+    {
+        Board copy( board );
+        check += copy.size();
+    }
+    const double copy_us = std::chrono::duration<double, std::micro>( Clock::now() - start ).count();
+
+    BlackboardConcurrent backend;
+    backend.set( "entry", board.at("entry_0") );
+    const int gets = 100000;
+    start = Clock::now();
+    for (int i=0; i<gets; i++)
+    {
+        check += backend.get("entry")->extractPtr<std::vector<uint8_t>>()->size();
+    }
+    const double get_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    printf("%s %9.1f us/board copy  %7.1f ns/get  (%zu)\n", name,
+           copy_us / copies, get_ns / gets, check);
+}
+
+int main()
+{
+    benchmark("deep:  ", false);
+    benchmark("shared:", true);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdio>
+#include "Blackboard/blackboard_sqlite.h"
+
+// Sustained set() per second: BlackboardSqlite versus a naive implementation
+// that executes one INSERT statement (and one transaction) per set.
+// The naive one runs twice, with the default journal and with the journal of
+// BlackboardSqlite, so that the effect of WAL and the one of batching are
+// reported separately.
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+static double naive(const char* filename, int iterations, int keys, bool wal)
+{
+    sqlite3* db = nullptr;
+    sqlite3_open(filename, &db);
+    if( wal ){
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;",
+                     nullptr, nullptr, nullptr);
+    }
+    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS blackboard("
+                     "key TEXT PRIMARY KEY NOT NULL, value BLOB NOT NULL);",
+                 nullptr, nullptr, nullptr);
+
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        const std::string key = "key_" + std::to_string(i % keys);
+        const double value = i;
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO blackboard(key, value) VALUES(?1, ?2);",
+                           -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, key.data(), static_cast<int>(key.size()), SQLITE_STATIC);
+        sqlite3_bind_blob(stmt, 2, &value, sizeof(value), SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    const double sets_per_sec = iterations / elapsed(start);
+    sqlite3_close(db);
+    return sets_per_sec;
+}
+
+static double batched(const char* filename, int iterations, int keys)
+{
+    BlackboardSqlite bb(filename);
+
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        bb.set( "key_" + std::to_string(i % keys), SafeAny::Any( double(i) ) );
+    }
+    bb.flush();
+    return iterations / elapsed(start);
+}
+
+int main()
+{
+    const char* naive_file = "/tmp/blackboard_naive.db";
+    const char* naive_wal_file = "/tmp/blackboard_naive_wal.db";
+    const char* batched_file = "/tmp/blackboard_batched.db";
+    std::remove(naive_file);
+    std::remove(naive_wal_file);
+    std::remove(batched_file);
+
+    // more keys than the batch size, so that every set() is eventually written
+    const int keys = 100000;
+    printf("naive   (statement per set):       %12.0f sets/sec\n", naive(naive_file, 2000, keys, false) );
+    printf("naive   (statement per set, WAL):  %12.0f sets/sec\n", naive(naive_wal_file, 2000, keys, true) );
+    printf("batched (BlackboardSqlite, WAL):   %12.0f sets/sec\n", batched(batched_file, 1000000, keys) );
+
+    for(const char* file: {naive_file, naive_wal_file, batched_file})
+    {
+        std::remove(file);
+        std::remove( (std::string(file) + "-wal").c_str() );
+        std::remove( (std::string(file) + "-shm").c_str() );
+    }
+    return 0;
+}
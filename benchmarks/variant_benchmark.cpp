@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_variant.h"
+
+// BlackboardVariant (closed set of types, inlined get/convert) versus BlackboardLocal,
+// through BasicBlackboard and the type-erased Blackboard.
+// set(): int32_t values overwritten with the same type.
+// get(): int32_t values read as int32_t and as double.
+
+using Clock = std::chrono::steady_clock;
+
+typedef BlackboardVariant<double, int32_t, std::string, std::vector<double>> Variant;
+
+template <typename T, typename BB>
+static double benchmarkGet(const BB& bb, const std::vector<std::string>& keys, int iterations)
+{
+    double sum = 0;
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        for(const auto& key: keys)
+        {
+            T value = 0;
+            bb.get(key, value);
+            sum += value;
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+    if( sum < 0 ) { printf("%f\n", sum); } // keep the result alive
+    return ns / (double(iterations) * keys.size());
+}
+
+template <typename BB>
+static double benchmarkSet(BB& bb, const std::vector<std::string>& keys, int iterations)
+{
+    auto start = Clock::now();
+    for (int i=0; i<iterations; i++)
+    {
+        for (std::size_t k=0; k<keys.size(); k++) {
+            bb.set( keys[k], int32_t(i + k) );
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+    return ns / (double(iterations) * keys.size());
+}
+
+template <typename BB>
+static void report(const char* name, BB& bb, const std::vector<std::string>& keys, int iterations)
+{
+    const double set_ns = benchmarkSet(bb, keys, iterations);
+    const double get_ns = benchmarkGet<int32_t>(bb, keys, iterations);
+    const double convert_ns = benchmarkGet<double>(bb, keys, iterations);
+    printf("%-38s set %6.1f ns  get %6.1f ns  get as double %6.1f ns\n", name, set_ns, get_ns, convert_ns);
+}
+
+int main()
+{
+    std::vector<std::string> keys;
+    for (int i=0; i<100; i++) {
+        keys.push_back( "key_" + std::to_string(i) );
+    }
+    const int iterations = 20000;
+
+    Variant variant;
+    BasicBlackboard<BlackboardLocal> static_local;
+    Blackboard dynamic_local( std::unique_ptr<BlackboardLocal>( new BlackboardLocal ) );
+    Blackboard dynamic_variant( std::unique_ptr<Variant>( new Variant ) );
+
+    report("BlackboardVariant", variant, keys, iterations);
+    report("BasicBlackboard<BlackboardLocal>", static_local, keys, iterations);
+    report("Blackboard(BlackboardLocal)", dynamic_local, keys, iterations);
+    report("Blackboard(BlackboardVariant)", dynamic_variant, keys, iterations);
+    return 0;
+}
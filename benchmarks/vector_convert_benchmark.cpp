@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+// A vector of 100k numbers stored in an Any and read as a vector of another type:
+// tryConvert() of the whole vector versus a loop of scalar safe conversions and
+// a plain memcpy of the same amount of bytes (the memory bandwidth bound).
+
+using Clock = std::chrono::steady_clock;
+using SafeAny::Any;
+
+template <typename SRC, typename DST>
+static void benchmark(const char* name, const std::vector<SRC>& values)
+{
+    const Any any( values );
+    std::vector<DST> out( values.size() );
+    std::vector<SRC> copy( values.size() );
+    const int iterations = 500;
+    std::size_t failures = 0;
+
+    auto start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        const std::vector<SRC>& stored = values;
+        for (std::size_t i=0; i<stored.size(); i++)
+        {
+            failures += SafeAny::details::convert_number( stored[i], out[i] ) != SafeAny::ConversionError::Ok;
+        }
+    }
+    const double scalar_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        failures += any.tryConvert( out ) != SafeAny::ConversionError::Ok;
+    }
+    const double vector_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    start = Clock::now();
+    for (int n=0; n<iterations; n++)
+    {
+        memcpy( copy.data(), values.data(), values.size() * sizeof(SRC) );
+        asm volatile("" : : "r"(copy.data()) : "memory");
+    }
+    const double memcpy_ns = std::chrono::duration<double, std::nano>( Clock::now() - start ).count();
+
+    const double count = double(iterations) * values.size();
+    printf("%-18s scalar %5.2f ns/value  vector %5.2f ns/value  memcpy %5.2f ns/value  (%zu failures)\n",
+           name, scalar_ns / count, vector_ns / count, memcpy_ns / count, failures);
+}
+
+int main()
+{
+    const std::size_t size = 100000;
+    std::vector<int32_t> ints( size );
+    std::vector<uint16_t> words( size );
+    std::vector<double> doubles( size );
+    std::vector<double> integers( size );
+    for (std::size_t i=0; i<size; i++)
+    {
+        ints[i] = int32_t(i) - 50000;
+        words[i] = uint16_t(i % 256);
+        doubles[i] = double(i % 1000) * 0.25;
+        integers[i] = double(i % 1000) - 500.0;
+    }
+    benchmark<int32_t, double>("int32 -> double", ints);
+    benchmark<int32_t, int16_t>("int32 -> int16 (fail)", ints);
+    benchmark<uint16_t, uint8_t>("uint16 -> uint8", words);
+    benchmark<double, float>("double -> float", doubles);
+    benchmark<double, int32_t>("double -> int32", integers);
+    return 0;
+}
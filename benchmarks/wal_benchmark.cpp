@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "Blackboard/blackboard_wal.h"
+
+// - recovery time of a board with 1M entries (snapshot + log tail)
+// - throughput of group commit with concurrent writers
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+static void removeFiles(const std::string& filename)
+{
+    std::remove( (filename + ".log").c_str() );
+    std::remove( (filename + ".snapshot").c_str() );
+}
+
+int main()
+{
+    const std::string filename("/tmp/blackboard_wal_benchmark");
+    removeFiles(filename);
+
+    const int entries = 1000000;
+    const int tail = 10000;
+    {
+        BlackboardWal bb(filename, false);
+        for (int i=0; i<entries; i++){
+            bb.set( "key_" + std::to_string(i), SafeAny::Any( double(i) ) );
+        }
+        bb.compact();
+        for (int i=0; i<tail; i++){
+            bb.set( "key_" + std::to_string(i), SafeAny::Any( double(-i) ) );
+        }
+        bb.sync();
+    }
+    {
+        auto start = Clock::now();
+        BlackboardWal bb(filename);
+        printf("recovery of %zu entries (+%d records in the log): %.3f sec\n",
+               bb.size(), tail, elapsed(start) );
+    }
+    removeFiles(filename);
+
+    for(int threads_count: {1, 4, 16})
+    {
+        BlackboardWal bb(filename);
+        const int sets_per_thread = 200;
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int t=0; t<threads_count; t++)
+        {
+            threads.emplace_back( [&bb, t, sets_per_thread]()
+            {
+                for (int i=0; i<sets_per_thread; i++){
+                    bb.set( "key_" + std::to_string(t), SafeAny::Any(i) );
+                }
+            });
+        }
+        for(auto& th: threads) { th.join(); }
+        printf("group commit, %2d threads: %10.0f durable sets/sec\n",
+               threads_count, threads_count * sets_per_thread / elapsed(start) );
+        removeFiles(filename);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#ifndef BLACKBOARD_ALLOCATION_MONITOR_H
+#define BLACKBOARD_ALLOCATION_MONITOR_H
+
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// Detects the heap allocations done by the real-time code (e.g. the tick of a
+// control loop), which must not allocate once it is initialized.
+//
+// The replacements of the global operator new/delete that count the allocations
+// are defined by the macro BLACKBOARD_ALLOCATION_MONITOR_HOOKS, to be expanded
+// in exactly one translation unit of the application (test or debug builds):
+//
+//   BLACKBOARD_ALLOCATION_MONITOR_HOOKS
+//
+//   void tick()
+//   {
+//       AllocationMonitor::Section section;
+//       ...
+//       if( section.allocations() > 0 ) { ... }
+//   }
+//
+// A handler can be installed to report every allocation done inside a Section
+// (for instance to print a stack trace or to abort).
+class AllocationMonitor
+{
+public:
+
+    typedef void (*Handler)(std::size_t size);
+
+    static void setHandler(Handler handler) { handlerStorage().store(handler); }
+
+    // Allocations done by the current thread since the beginning of the process.
+    static std::size_t allocations() { return threadCounter(); }
+
+    // False if BLACKBOARD_ALLOCATION_MONITOR_HOOKS was not expanded: nothing is counted.
+    static bool enabled() { return enabledFlag().load(); }
+
+    // Real-time section of the current thread.
+    class Section
+    {
+    public:
+        Section(): start_( threadCounter() ) { threadDepth()++; }
+        ~Section() { threadDepth()--; }
+
+        Section(const Section&) = delete;
+        Section& operator=(const Section&) = delete;
+
+        std::size_t allocations() const { return threadCounter() - start_; }
+
+    private:
+        std::size_t start_;
+    };
+
+    // Called by the hooks.
+    static void onAllocation(std::size_t size)
+    {
+        threadCounter()++;
+        Handler handler = handlerStorage().load();
+        if( handler && threadDepth() > 0 && !threadReporting() )
+        {
+            threadReporting() = true;  // the handler itself might allocate
+            handler(size);
+            threadReporting() = false;
+        }
+    }
+
+    static void enable() { enabledFlag().store(true); }
+
+private:
+    static std::size_t& threadCounter()           { static thread_local std::size_t value = 0; return value; }
+    static int& threadDepth()                     { static thread_local int value = 0; return value; }
+    static bool& threadReporting()                { static thread_local bool value = false; return value; }
+    static std::atomic<Handler>& handlerStorage() { static std::atomic<Handler> value(nullptr); return value; }
+    static std::atomic<bool>& enabledFlag()       { static std::atomic<bool> value(false); return value; }
+};
+
+
+// The replacements are not inlined: otherwise GCC sees, for instance, a free() of
+// a pointer returned by operator new and warns about it (-Wmismatched-new-delete).
+#define BLACKBOARD_ALLOCATION_MONITOR_HOOKS \
+    __attribute__((noinline)) void* operator new(std::size_t size) \
+    { \
+        AllocationMonitor::onAllocation(size); \
+        if( void* ptr = std::malloc(size ? size : 1) ) { return ptr; } \
+        throw std::bad_alloc(); \
+    } \
+    __attribute__((noinline)) void* operator new[](std::size_t size) { return operator new(size); } \
+    __attribute__((noinline)) void* operator new(std::size_t size, const std::nothrow_t&) noexcept \
+    { \
+        AllocationMonitor::onAllocation(size); \
+        return std::malloc(size ? size : 1); \
+    } \
+    __attribute__((noinline)) void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept \
+    { return operator new(size, tag); } \
+    __attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete[](void* ptr) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); } \
+    BLACKBOARD_ALLOCATION_MONITOR_ALIGNED_HOOKS \
+    static const bool blackboard_allocation_monitor_enabled = (AllocationMonitor::enable(), true);
+
+// Over-aligned types (C++17).
+#ifdef __cpp_aligned_new
+#define BLACKBOARD_ALLOCATION_MONITOR_ALIGNED_HOOKS \
+    __attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept \
+    { \
+        AllocationMonitor::onAllocation(size); \
+        void* ptr = nullptr; \
+        const std::size_t alignment = std::max( static_cast<std::size_t>(align), sizeof(void*) ); \
+        return posix_memalign( &ptr, alignment, size ? size : 1 ) == 0 ? ptr : nullptr; \
+    } \
+    __attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t align) \
+    { \
+        if( void* ptr = operator new(size, align, std::nothrow) ) { return ptr; } \
+        throw std::bad_alloc(); \
+    } \
+    __attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); } \
+    __attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t& tag) noexcept \
+    { return operator new(size, align, tag); } \
+    __attribute__((noinline)) void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); } \
+    __attribute__((noinline)) void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+#else
+#define BLACKBOARD_ALLOCATION_MONITOR_ALIGNED_HOOKS
+#endif
+
+
+#endif // BLACKBOARD_ALLOCATION_MONITOR_H
@@ -4,12 +4,37 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <array>
+#include <vector>
 #include <stdint.h>
 #include <unordered_map>
 
 #include <SafeAny/safe_any.hpp>
 
 
+// Reads and buffered writes of an optimistic transaction (see BlackboardTransaction).
+struct BlackboardTransactionLog
+{
+    struct Read
+    {
+        std::string key;
+        uint64_t version;
+        bool found;
+        SafeAny::Any value;
+    };
+
+    struct Write
+    {
+        std::string key;
+        SafeAny::Any value;
+    };
+
+    uint64_t snapshot = 0;
+    std::vector<Read> reads;
+    std::vector<Write> writes;
+};
+
+
 class BlackboardImpl
 {
 public:
@@ -18,57 +43,409 @@ public:
 
     virtual const SafeAny::Any* get(const std::string& key) const = 0;
     virtual void set(const std::string& key, const SafeAny::Any& value) = 0;
+
+    // Same as get(), but also returns the cache of the last conversion of the entry
+    // (see SafeAny::ConversionCache), used by the front-ends to read numbers.
+    // "cache" is nullptr if the backend doesn't keep one (the default).
+    virtual const SafeAny::Any* getCached(const std::string& key, SafeAny::ConversionCache*& cache) const
+    {
+        cache = nullptr;
+        return get(key);
+    }
+
+    // Store a value that the caller doesn't need anymore. Backends which keep
+    // it in memory take it without copies: this is the only way to store
+    // move-only values. The default implementation copies it.
+    virtual void set(const std::string& key, SafeAny::Any&& value)
+    {
+        set(key, static_cast<const SafeAny::Any&>(value));
+    }
+
+    // Stored value that the front-end may assign in place when the type doesn't
+    // change, without creating a temporary SafeAny::Any; nullptr if the backend
+    // doesn't allow it (the default) or the key doesn't exist.
+    virtual SafeAny::Any* slot(const std::string& key)
+    {
+        (void)key;
+        return nullptr;
+    }
+
+    // Batched access to "count" keys. getMany() copies the values into values[]
+    // and sets found[i] to false when keys[i] doesn't exist.
+    // The default implementations call get() and set() once per key; concurrent
+    // backends override them to take each lock only once per call.
+    virtual void getMany(const std::string* keys, std::size_t count,
+                         SafeAny::Any* values, bool* found) const
+    {
+        for(std::size_t i=0; i<count; i++)
+        {
+            const SafeAny::Any* val = get(keys[i]);
+            found[i] = (val != nullptr);
+            if( val ) { values[i] = *val; }
+        }
+    }
+
+    virtual void setMany(const std::string* keys, const SafeAny::Any* values, std::size_t count)
+    {
+        for(std::size_t i=0; i<count; i++)
+        {
+            set(keys[i], values[i]);
+        }
+    }
+
+    // Optimistic transactions.
+    // The default implementations are valid only for backends which are not
+    // shared between threads: there are no versions and commit() never fails.
+
+    // Version of the current state, the snapshot seen by a new transaction.
+    virtual uint64_t snapshot() const { return 0; }
+
+    // Read "key" and its version. Returns false if the entry was modified
+    // after "snapshot": the transaction must be restarted.
+    virtual bool readVersioned(const std::string& key, uint64_t snapshot,
+                               BlackboardTransactionLog::Read& read) const
+    {
+        (void)snapshot;
+        const SafeAny::Any* val = get(key);
+        read.key = key;
+        read.version = 0;
+        read.found = (val != nullptr);
+        if( val ) { read.value = *val; }
+        return true;
+    }
+
+    // Apply the writes atomically if none of the entries read has been modified
+    // in the meantime. Returns false otherwise.
+    virtual bool commit(const BlackboardTransactionLog& log)
+    {
+        for(const auto& write: log.writes){
+            set(write.key, write.value);
+        }
+        return true;
+    }
 };
 
+class BlackboardTransaction;
 
-// Blackboard is the front-end to be used by the developer.
-// Even if the abstract class BlackboardImpl can be used directly,
-// the templatized methods set() and get() are more user-friendly
-class Blackboard
+
+// Implementation of the user-friendly API shared by the front-ends
+// Blackboard and BasicBlackboard (CRTP: Derived must provide backend()).
+template <typename Derived>
+class BlackboardFrontEnd
 {
 public:
 
-    Blackboard( std::unique_ptr<BlackboardImpl> implementation):
-        impl_( std::move(implementation ) )
-    { }
-
-    virtual ~Blackboard() = default;
-
     template <typename T> bool get(const std::string& key, T& value) const
     {
         return getImpl(key, value);
     }
 
-    template <typename T> void set(const std::string& key, const T& value) {
-        setImpl(key, value);
+    // Same as get(), but a failed conversion is returned as an error code instead of
+    // thrown (a missing key is ConversionError::MissingKey). "value" is written only
+    // on success.
+    template <typename T> SafeAny::ConversionError tryGet(const std::string& key, T& value) const
+    {
+        SafeAny::ConversionCache* cache = nullptr;
+        const SafeAny::Any* val = derived().backend().getCached(key, cache);
+        if( !val ){ return SafeAny::ConversionError::MissingKey; }
+        return cache ? cache->convert(*val, value) : val->tryConvert(value);
+    }
+
+    // Same as tryGet(), but a string is parsed if T is a number (see Any::tryParse()).
+    // The parsed number is cached in the entry, as long as its value doesn't change.
+    template <typename T> SafeAny::ConversionError tryParse(const std::string& key, T& value) const
+    {
+        const SafeAny::Any* val = derived().backend().get(key);
+        if( !val ){ return SafeAny::ConversionError::MissingKey; }
+        return val->tryParse(value);
     }
 
+    // Rvalues are moved into the blackboard (also move-only types, if the backend supports them).
+    template <typename T> void set(const std::string& key, T&& value) {
+        setImpl(key, std::forward<T>(value));
+    }
+
+    // Pointer to the value stored by the backend if its type is exactly T, without
+    // copying it (e.g. to read a move-only value); nullptr otherwise.
+    // Valid until the key is modified; backends that don't keep the values in
+    // memory return a pointer to a temporary copy.
+    template <typename T> const T* getPtr(const std::string& key) const
+    {
+        const SafeAny::Any* val = derived().backend().get(key);
+        return val ? val->extractPtr<T>() : nullptr;
+    }
+
+    // Construct the value of "key" in place, as T(args...), when the backend
+    // allows it (see BlackboardImpl::slot()); otherwise it is the same as
+    // set(key, T(args...)).
+    //
+    //    bb.emplace<std::vector<double>>("ranges", 360, 0.0);
+    //
+    template <typename T, typename... Args> void emplace(const std::string& key, Args&&... args)
+    {
+        if( SafeAny::Any* slot = derived().backend().slot(key) ) {
+            slot->template emplace<T>( std::forward<Args>(args)... );
+        }
+        else{
+            setImpl( key, T( std::forward<Args>(args)... ) );
+        }
+    }
+
+    // Read several keys with a single call to the backend:
+    //
+    //    double x, y; int64_t stamp;
+    //    bb.getMany( {"x", "y", "stamp"}, x, y, stamp );
+    //
+    // Returns false if any key is missing; the corresponding values are not modified.
+    template <typename... T>
+    bool getMany(const std::array<std::string, sizeof...(T)>& keys, T&... values) const
+    {
+        static_assert( sizeof...(T) > 0, "getMany requires at least one key");
+        SafeAny::Any anys[sizeof...(T)];
+        bool found[sizeof...(T)];
+        derived().backend().getMany( keys.data(), sizeof...(T), anys, found );
+        return convertMany( anys, found, values... );
+    }
+
+    // Write several keys with a single call to the backend.
+    template <typename... T>
+    void setMany(const std::array<std::string, sizeof...(T)>& keys, const T&... values)
+    {
+        static_assert( sizeof...(T) > 0, "setMany requires at least one key");
+        const SafeAny::Any anys[sizeof...(T)] = { toAny(values)... };
+        derived().backend().setMany( keys.data(), anys, sizeof...(T) );
+    }
+
+    // Execute func(BlackboardTransaction&) atomically: the transaction reads a
+    // consistent snapshot and buffers its writes, which are applied at the end
+    // only if the entries read were not modified by other threads. Otherwise
+    // func is executed again, therefore it should have no other side effects.
+    //
+    //    bb.transaction( [&](BlackboardTransaction& tx) {
+    //        double x;
+    //        tx.get("x", x);
+    //        tx.setMany( {"x", "stamp"}, x + dx, stamp );
+    //    });
+    //
+    template <typename Func, typename Transaction = BlackboardTransaction>
+    void transaction(Func func)
+    {
+        Transaction tx( derived().backend() );
+        while( true )
+        {
+            tx.begin();
+            try{
+                func(tx);
+            }
+            catch(typename Transaction::Conflict&) {
+                continue;
+            }
+            if( tx.commit() ) { return; }
+        }
+    }
+
+protected:
+
+    ~BlackboardFrontEnd() = default;
+
 private:
 
-    // Not a number, nor a std::string, nor a const char*
+    Derived& derived() { return *static_cast<Derived*>(this); }
+    const Derived& derived() const { return *static_cast<const Derived*>(this); }
+
     template <typename T>
-    void setImpl(const std::string& key,const T& value)
+    void setImpl(const std::string& key, T&& value)
     {
-        impl_->set(key, SafeAny::Any(value));
+        SafeAny::Any* slot = derived().backend().slot(key);
+        if( slot && slot->assignInPlace( std::forward<T>(value) ) ) { return; }
+        derived().backend().set(key, SafeAny::Any( std::forward<T>(value) ));
     }
 
     void setImpl(const std::string& key,const char* value)
     {
-        impl_->set(key, std::string(value));
+        SafeAny::Any* slot = derived().backend().slot(key);
+        if( slot && slot->assignInPlace(value) ) { return; }
+        derived().backend().set(key, std::string(value));
     }
 
     template <typename T>
     bool getImpl(const std::string& key, T& value) const
     {
-        const SafeAny::Any* val = impl_->get(key);
-        if( !val ){ return false; }
-
-        value = val->convert<T>();
+        const SafeAny::ConversionError error = tryGet(key, value);
+        if( error == SafeAny::ConversionError::MissingKey ){ return false; }
+        if( error != SafeAny::ConversionError::Ok ){ SafeAny::details::throwConversionError(error); }
         return true;
     }
 
+    template <typename T>
+    static SafeAny::Any toAny(const T& value) { return SafeAny::Any(value); }
+
+    static SafeAny::Any toAny(const char* value) { return SafeAny::Any( std::string(value) ); }
+
+    static bool convertMany(const SafeAny::Any*, const bool*) { return true; }
+
+    template <typename First, typename... Rest>
+    static bool convertMany(const SafeAny::Any* anys, const bool* found, First& first, Rest&... rest)
+    {
+        if( *found ) { anys->convertTo(first); }
+        return convertMany( anys+1, found+1, rest... ) && *found;
+    }
+};
+
+
+// Blackboard is the front-end to be used by the developer.
+// Even if the abstract class BlackboardImpl can be used directly,
+// the templatized methods set() and get() are more user-friendly
+class Blackboard: public BlackboardFrontEnd<Blackboard>
+{
+public:
+
+    Blackboard( std::unique_ptr<BlackboardImpl> implementation):
+        impl_( std::move(implementation ) )
+    { }
+
+    virtual ~Blackboard() = default;
+
+private:
+
+    friend class BlackboardFrontEnd<Blackboard>;
+
+    BlackboardImpl& backend() { return *impl_; }
+    const BlackboardImpl& backend() const { return *impl_; }
+
     std::unique_ptr<BlackboardImpl> impl_;
 };
 
 
+// Same API of Blackboard, for builds where the backend is known at compile time.
+// The backend is stored by value and called without virtual dispatch, so that
+// the compiler can inline the lookup and the conversion into the caller.
+//
+//    BasicBlackboard<BlackboardLocal> bb;
+//
+template <typename Impl>
+class BasicBlackboard: public BlackboardFrontEnd< BasicBlackboard<Impl> >
+{
+public:
+
+    template <typename... Args>
+    explicit BasicBlackboard(Args&&... args):
+        impl_( std::forward<Args>(args)... )
+    { }
+
+    Impl& implementation() { return impl_; }
+    const Impl& implementation() const { return impl_; }
+
+private:
+
+    friend class BlackboardFrontEnd< BasicBlackboard<Impl> >;
+
+    Impl& backend() { return impl_; }
+    const Impl& backend() const { return impl_; }
+
+    Impl impl_;
+};
+
+
+// Transaction created by BlackboardFrontEnd::transaction(); it has the same
+// get/set API of the Blackboard, reads its own writes and doesn't modify the
+// backend until commit().
+class BlackboardTransaction: public BlackboardFrontEnd<BlackboardTransaction>
+{
+public:
+
+    // Thrown by get() when the entry was modified after the transaction started.
+    // Not derived from std::exception: transaction() catches it and retries.
+    struct Conflict {};
+
+    explicit BlackboardTransaction(BlackboardImpl& impl): buffer_(impl) {}
+
+    BlackboardTransaction(const BlackboardTransaction&) = delete;
+    BlackboardTransaction& operator=(const BlackboardTransaction&) = delete;
+
+    void begin()
+    {
+        buffer_.log.snapshot = buffer_.impl.snapshot();
+        buffer_.log.reads.clear();
+        buffer_.log.writes.clear();
+    }
+
+    bool commit()
+    {
+        if( buffer_.log.writes.empty() ) { return true; } // the snapshot was consistent
+        return buffer_.impl.commit( buffer_.log );
+    }
+
+private:
+
+    friend class BlackboardFrontEnd<BlackboardTransaction>;
+
+    struct Buffer
+    {
+        explicit Buffer(BlackboardImpl& backend): impl(backend) {}
+
+        const SafeAny::Any* get(const std::string& key) const
+        {
+            for(const auto& write: log.writes){
+                if( write.key == key ) { return &write.value; }
+            }
+            for(const auto& read: log.reads){
+                if( read.key == key ) { return read.found ? &read.value : nullptr; }
+            }
+            log.reads.emplace_back();
+            BlackboardTransactionLog::Read& read = log.reads.back();
+            if( !impl.readVersioned( key, log.snapshot, read ) ) {
+                throw Conflict();
+            }
+            return read.found ? &read.value : nullptr;
+        }
+
+        const SafeAny::Any* getCached(const std::string& key, SafeAny::ConversionCache*& cache) const
+        {
+            cache = nullptr;
+            return get(key);
+        }
+
+        SafeAny::Any* slot(const std::string&) { return nullptr; }
+
+        void set(const std::string& key, const SafeAny::Any& value)
+        {
+            for(auto& write: log.writes)
+            {
+                if( write.key == key ) {
+                    write.value = value;
+                    return;
+                }
+            }
+            log.writes.push_back( {key, value} );
+        }
+
+        void getMany(const std::string* keys, std::size_t count, SafeAny::Any* values, bool* found) const
+        {
+            for(std::size_t i=0; i<count; i++)
+            {
+                const SafeAny::Any* val = get(keys[i]);
+                found[i] = (val != nullptr);
+                if( val ) { values[i] = *val; }
+            }
+        }
+
+        void setMany(const std::string* keys, const SafeAny::Any* values, std::size_t count)
+        {
+            for(std::size_t i=0; i<count; i++){
+                set(keys[i], values[i]);
+            }
+        }
+
+        BlackboardImpl& impl;
+        mutable BlackboardTransactionLog log;
+    };
+
+    Buffer& backend() { return buffer_; }
+    const Buffer& backend() const { return buffer_; }
+
+    Buffer buffer_;
+};
+
+
 #endif // BLACKBOARD_H
@@ -0,0 +1,412 @@
+#ifndef BLACKBOARD_ASYNC_LOG_H
+#define BLACKBOARD_ASYNC_LOG_H
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "blackboard_wal.h"
+
+// Backend with asynchronous persistence, meant to be used by a real-time (tick) thread.
+//
+// set() updates the in-memory map, serializes the change and pushes it into a
+// lock-free single-producer/single-consumer ring buffer; nothing else happens on
+// the calling thread. A background thread drains the ring and appends the records
+// to the log with io_uring (a write linked to an fdatasync), or with plain
+// write() + fdatasync() when io_uring is not available.
+//
+// The log has the same format as BlackboardWal and it is recovered by the
+// constructor; use BlackboardWal::compact() offline to compact it.
+//
+// If writing the log fails, the background thread stops persisting: the error
+// is rethrown by flush() and by every following set().
+//
+// Like BlackboardLocal, get() and set() must be called by a single thread.
+// Only numbers and strings can be stored.
+class BlackboardAsyncLog: public BlackboardImpl
+{
+public:
+
+    BlackboardAsyncLog(const std::string& filename,
+                       std::size_t ring_size = 1024*1024,
+                       bool use_io_uring = true);
+
+    virtual ~BlackboardAsyncLog() override;
+
+    BlackboardAsyncLog(const BlackboardAsyncLog&) = delete;
+    BlackboardAsyncLog& operator=(const BlackboardAsyncLog&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override
+    {
+        auto it = storage_.find(key);
+        if( it == storage_.end() ){ return nullptr; }
+        return &(it->second);
+    }
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override;
+
+    // Block until all the previous set() are on disk.
+    // Throws the error of the background thread, if any.
+    void flush();
+
+    // True if the background thread is using io_uring.
+    bool usingIoUring() const { return uring_ready_.load(); }
+
+    // Number of times set() had to wait because the ring buffer was full.
+    uint64_t stalls() const { return stalls_; }
+
+private:
+
+    // Minimal io_uring wrapper (no liburing): one write linked to one fdatasync at a time.
+    class IoUring
+    {
+    public:
+        IoUring(): fd_(-1), sq_ptr_(nullptr), cq_ptr_(nullptr), sqes_(nullptr),
+                   sq_size_(0), cq_size_(0), sqes_size_(0) {}
+        ~IoUring();
+
+        bool init(unsigned entries);
+
+        // Returns false if the kernel refused the request; the caller must fall back.
+        bool writeAndSync(int file_fd, const char* data, std::size_t size);
+
+    private:
+        int fd_;
+        void* sq_ptr_;
+        void* cq_ptr_;
+        io_uring_sqe* sqes_;
+        std::size_t sq_size_;
+        std::size_t cq_size_;
+        std::size_t sqes_size_;
+        io_uring_params params_;
+    };
+
+    // Lock-free single producer, single consumer ring of bytes.
+    // A record is pushed entirely or not at all.
+    class Ring
+    {
+    public:
+        Ring(std::size_t size);
+
+        bool push(const char* data, std::size_t size);
+
+        // Append all the available bytes to out. Returns the number of bytes.
+        std::size_t pop(std::string& out);
+
+        std::size_t capacity() const { return buffer_.size(); }
+
+    private:
+        std::vector<char> buffer_;
+        std::size_t mask_;
+        alignas(64) std::atomic<std::size_t> head_; // written by the producer
+        alignas(64) std::atomic<std::size_t> tail_; // written by the consumer
+    };
+
+    void backgroundLoop();
+
+    void persist(const std::string& batch);
+
+    void rethrowError() const;
+
+    BlackboardWal::Storage storage_;
+    std::string record_;
+    Ring ring_;
+    int log_fd_;
+
+    IoUring uring_;
+    std::atomic<bool> uring_ready_;
+
+    std::atomic<bool> stop_;
+    std::atomic<uint64_t> pushed_bytes_;
+    std::atomic<uint64_t> persisted_bytes_;
+    std::exception_ptr error_;    // written once by the background thread,
+    std::atomic<bool> failed_;    // before setting failed_
+    uint64_t stalls_;
+    std::thread thread_;
+};
+
+//----------------------------------------------------------
+
+inline BlackboardAsyncLog::IoUring::~IoUring()
+{
+    if( sqes_ )   { munmap( sqes_, sqes_size_ ); }
+    if( cq_ptr_ && cq_ptr_ != sq_ptr_ ) { munmap( cq_ptr_, cq_size_ ); }
+    if( sq_ptr_ ) { munmap( sq_ptr_, sq_size_ ); }
+    if( fd_ >= 0 ) { close(fd_); }
+}
+
+inline bool BlackboardAsyncLog::IoUring::init(unsigned entries)
+{
+    memset( &params_, 0, sizeof(params_) );
+    fd_ = static_cast<int>( syscall( __NR_io_uring_setup, entries, &params_ ) );
+    if( fd_ < 0 ) { return false; }
+
+    sq_size_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cq_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params_.features & IORING_FEAT_SINGLE_MMAP;
+    if( single_mmap ){
+        sq_size_ = cq_size_ = std::max( sq_size_, cq_size_ );
+    }
+
+    sq_ptr_ = mmap( nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING );
+    if( sq_ptr_ == MAP_FAILED ) { sq_ptr_ = nullptr; return false; }
+
+    if( single_mmap ){
+        cq_ptr_ = sq_ptr_;
+    }
+    else{
+        cq_ptr_ = mmap( nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING );
+        if( cq_ptr_ == MAP_FAILED ) { cq_ptr_ = nullptr; return false; }
+    }
+
+    sqes_size_ = params_.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap( nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES );
+    if( sqes == MAP_FAILED ) { return false; }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    return params_.sq_entries >= 2;
+}
+
+inline bool BlackboardAsyncLog::IoUring::writeAndSync(int file_fd, const char* data, std::size_t size)
+{
+    char* sq = static_cast<char*>(sq_ptr_);
+    char* cq = static_cast<char*>(cq_ptr_);
+
+    auto* sq_tail  = reinterpret_cast<std::atomic<unsigned>*>( sq + params_.sq_off.tail );
+    const unsigned sq_mask = *reinterpret_cast<unsigned*>( sq + params_.sq_off.ring_mask );
+    auto* sq_array = reinterpret_cast<unsigned*>( sq + params_.sq_off.array );
+
+    auto* cq_head  = reinterpret_cast<std::atomic<unsigned>*>( cq + params_.cq_off.head );
+    auto* cq_tail  = reinterpret_cast<std::atomic<unsigned>*>( cq + params_.cq_off.tail );
+    const unsigned cq_mask = *reinterpret_cast<unsigned*>( cq + params_.cq_off.ring_mask );
+    auto* cqes     = reinterpret_cast<io_uring_cqe*>( cq + params_.cq_off.cqes );
+
+    // we are the only submitter and we always wait for the completions,
+    // so the submission queue is empty here.
+    const unsigned tail = sq_tail->load(std::memory_order_relaxed);
+
+    io_uring_sqe* write_sqe = &sqes_[ tail & sq_mask ];
+    memset( write_sqe, 0, sizeof(io_uring_sqe) );
+    write_sqe->opcode = IORING_OP_WRITE;
+    write_sqe->fd = file_fd;
+    write_sqe->addr = reinterpret_cast<uint64_t>(data);
+    write_sqe->len = static_cast<uint32_t>(size);
+    write_sqe->off = 0; // ignored, the file is opened with O_APPEND
+    write_sqe->flags = IOSQE_IO_LINK;
+    sq_array[ tail & sq_mask ] = tail & sq_mask;
+
+    io_uring_sqe* sync_sqe = &sqes_[ (tail+1) & sq_mask ];
+    memset( sync_sqe, 0, sizeof(io_uring_sqe) );
+    sync_sqe->opcode = IORING_OP_FSYNC;
+    sync_sqe->fd = file_fd;
+    sync_sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sq_array[ (tail+1) & sq_mask ] = (tail+1) & sq_mask;
+
+    sq_tail->store( tail + 2, std::memory_order_release );
+
+    int submitted = 0;
+    do{
+        submitted = static_cast<int>( syscall( __NR_io_uring_enter, fd_, 2, 2,
+                                               IORING_ENTER_GETEVENTS, nullptr, 0 ) );
+    } while( submitted < 0 && errno == EINTR );
+    if( submitted < 0 ) { return false; }
+
+    int write_res = -1;
+    int sync_res = -1;
+    unsigned head = cq_head->load(std::memory_order_relaxed);
+    for (int completed = 0; completed < 2; )
+    {
+        if( head == cq_tail->load(std::memory_order_acquire) )
+        {
+            if( syscall( __NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) < 0 &&
+                errno != EINTR )
+            {
+                return false;
+            }
+            continue;
+        }
+        const io_uring_cqe& cqe = cqes[ head & cq_mask ];
+        if( completed == 0 ) { write_res = cqe.res; }
+        else                 { sync_res = cqe.res; }
+        head++;
+        completed++;
+    }
+    cq_head->store( head, std::memory_order_release );
+
+    if( write_res < 0 ) { return false; }
+
+    // a short write cancels the linked fsync: finish the job synchronously
+    if( static_cast<std::size_t>(write_res) < size )
+    {
+        BlackboardWalDetails::writeAll( file_fd, data + write_res, size - write_res );
+        sync_res = -1;
+    }
+    if( sync_res < 0 && fdatasync(file_fd) != 0 ){
+        throw std::runtime_error("BlackboardAsyncLog: fdatasync failed");
+    }
+    return true;
+}
+
+inline BlackboardAsyncLog::Ring::Ring(std::size_t size):
+    head_(0), tail_(0)
+{
+    std::size_t capacity = 1024;
+    while( capacity < size ) { capacity *= 2; }
+    buffer_.resize(capacity);
+    mask_ = capacity - 1;
+}
+
+inline bool BlackboardAsyncLog::Ring::push(const char* data, std::size_t size)
+{
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    if( buffer_.size() - (head - tail) < size ) { return false; }
+
+    const std::size_t pos = head & mask_;
+    const std::size_t first = std::min( size, buffer_.size() - pos );
+    memcpy( &buffer_[pos], data, first );
+    memcpy( &buffer_[0], data + first, size - first );
+
+    head_.store( head + size, std::memory_order_release );
+    return true;
+}
+
+inline std::size_t BlackboardAsyncLog::Ring::pop(std::string& out)
+{
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t size = head - tail;
+    if( size == 0 ) { return 0; }
+
+    const std::size_t pos = tail & mask_;
+    const std::size_t first = std::min( size, buffer_.size() - pos );
+    out.append( &buffer_[pos], first );
+    out.append( &buffer_[0], size - first );
+
+    tail_.store( head, std::memory_order_release );
+    return size;
+}
+
+inline BlackboardAsyncLog::BlackboardAsyncLog(const std::string& filename,
+                                              std::size_t ring_size,
+                                              bool use_io_uring):
+    ring_(ring_size),
+    log_fd_(-1),
+    uring_ready_(false),
+    stop_(false),
+    pushed_bytes_(0),
+    persisted_bytes_(0),
+    failed_(false),
+    stalls_(0)
+{
+    std::size_t log_size = 0;
+    log_fd_ = BlackboardWal::recover( filename, storage_, log_size );
+
+    uring_ready_ = use_io_uring && uring_.init(8);
+    thread_ = std::thread( &BlackboardAsyncLog::backgroundLoop, this );
+}
+
+inline BlackboardAsyncLog::~BlackboardAsyncLog()
+{
+    stop_.store(true);
+    thread_.join();
+    close(log_fd_);
+}
+
+inline void BlackboardAsyncLog::set(const std::string& key, const SafeAny::Any& value)
+{
+    rethrowError();
+
+    record_.clear();
+    BlackboardWal::appendRecord( key, value, record_ );
+
+    if( record_.size() > ring_.capacity() ){
+        throw std::runtime_error("BlackboardAsyncLog: value too large for the ring buffer");
+    }
+
+    storage_[key] = value;
+
+    while( !ring_.push( record_.data(), record_.size() ) )
+    {
+        // the disk can't keep up: the only option left is to wait
+        rethrowError();
+        stalls_++;
+        std::this_thread::yield();
+    }
+    pushed_bytes_.fetch_add( record_.size(), std::memory_order_relaxed );
+}
+
+inline void BlackboardAsyncLog::flush()
+{
+    const uint64_t target = pushed_bytes_.load(std::memory_order_relaxed);
+    while( persisted_bytes_.load(std::memory_order_acquire) < target ){
+        rethrowError();
+        std::this_thread::sleep_for( std::chrono::microseconds(100) );
+    }
+}
+
+inline void BlackboardAsyncLog::rethrowError() const
+{
+    if( failed_.load(std::memory_order_acquire) ){
+        std::rethrow_exception( error_ );
+    }
+}
+
+inline void BlackboardAsyncLog::backgroundLoop()
+{
+    std::string batch;
+    while( true )
+    {
+        // read stop_ before draining, to be sure that nothing is left behind
+        const bool stop = stop_.load(std::memory_order_acquire);
+        batch.clear();
+        if( ring_.pop(batch) > 0 )
+        {
+            // after a failure the records are dropped: the log must not have holes
+            if( failed_.load(std::memory_order_relaxed) ){
+                continue;
+            }
+            try{
+                persist(batch);
+                persisted_bytes_.fetch_add( batch.size(), std::memory_order_release );
+            }
+            catch(...)
+            {
+                error_ = std::current_exception();
+                failed_.store( true, std::memory_order_release );
+            }
+        }
+        else if( stop ){
+            break;
+        }
+        else{
+            std::this_thread::sleep_for( std::chrono::microseconds(200) );
+        }
+    }
+}
+
+inline void BlackboardAsyncLog::persist(const std::string& batch)
+{
+    if( uring_ready_ )
+    {
+        if( uring_.writeAndSync( log_fd_, batch.data(), batch.size() ) ){
+            return;
+        }
+        // old kernel or io_uring disabled: use the plain thread from now on
+        uring_ready_ = false;
+    }
+    BlackboardWalDetails::writeAll( log_fd_, batch.data(), batch.size() );
+    if( fdatasync(log_fd_) != 0 ){
+        throw std::runtime_error("BlackboardAsyncLog: fdatasync failed");
+    }
+}
+
+
+#endif // BLACKBOARD_ASYNC_LOG_H
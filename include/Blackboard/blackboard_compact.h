@@ -0,0 +1,187 @@
+#ifndef BLACKBOARD_COMPACT_H
+#define BLACKBOARD_COMPACT_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include "blackboard.h"
+#include "SafeAny/compact_any.hpp"
+
+// Key/value storage for boards with millions of small entries (e.g. the cells of
+// a map, the bins of a histogram), mostly numbers.
+//
+// The entries are 24 bytes (key offset, key size and a SafeAny::CompactAny) in an
+// open addressing hash table with linear probing; the keys are packed one after
+// the other in a single buffer. Numbers take no other memory, the other values
+// are allocated on the heap. See benchmarks/memory_benchmark.cpp for the bytes
+// per entry of each backend.
+//
+// get() returns the boxed values directly, while the numbers are copied into a
+// SafeAny::Any owned by the blackboard, valid until the next call to get().
+// The typed tryGet() and get() read the numbers without that copy.
+class BlackboardCompact: public BlackboardImpl
+{
+public:
+
+    explicit BlackboardCompact(std::size_t capacity = 0): size_(0)
+    {
+        reserve(capacity);
+    }
+
+    BlackboardCompact(const BlackboardCompact&) = delete;
+    BlackboardCompact& operator=(const BlackboardCompact&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override
+    {
+        const Slot* slot = find(key);
+        if( !slot ){ return nullptr; }
+        if( const SafeAny::Any* boxed = slot->value.boxed() ) { return boxed; }
+        slot->value.toAny( scratch_ );
+        return &scratch_;
+    }
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override
+    {
+        insert(key).assign(value);
+    }
+
+    // Numbers are stored without creating a SafeAny::Any.
+    template <typename T>
+    typename std::enable_if< SafeAny::details::is_tagged_number<T>::value >::type
+    set(const std::string& key, T value)
+    {
+        insert(key).set(value);
+    }
+
+    using BlackboardImpl::set;
+
+    // Same as BlackboardFrontEnd::tryGet().
+    template <typename T> SafeAny::ConversionError tryGet(const std::string& key, T& value) const
+    {
+        const Slot* slot = find(key);
+        if( !slot ){ return SafeAny::ConversionError::MissingKey; }
+        return slot->value.tryConvert(value);
+    }
+
+    // Same as BlackboardFrontEnd::get(): false if the key is missing, throws if the conversion fails.
+    template <typename T> bool get(const std::string& key, T& value) const
+    {
+        const SafeAny::ConversionError error = tryGet(key, value);
+        if( error == SafeAny::ConversionError::MissingKey ){ return false; }
+        if( error != SafeAny::ConversionError::Ok ){ SafeAny::details::throwConversionError(error); }
+        return true;
+    }
+
+    std::size_t size() const { return size_; }
+
+    // Room for "count" entries without rehashing.
+    void reserve(std::size_t count)
+    {
+        std::size_t capacity = 16;
+        while( capacity * 3 < count * 4 ) { capacity *= 2; }
+        if( capacity > slots_.size() ) { rehash(capacity); }
+    }
+
+    // Memory used by the table and the keys (boxed values excluded).
+    std::size_t memoryUsage() const
+    {
+        return slots_.capacity() * sizeof(Slot) + keys_.capacity();
+    }
+
+private:
+
+    static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+    struct Slot
+    {
+        Slot(): key_offset(EMPTY_SLOT), key_size(0) {}
+
+        uint32_t key_offset;
+        uint32_t key_size;
+        SafeAny::CompactAny value;
+    };
+
+    static uint64_t hash(const char* data, std::size_t size)
+    {
+        // FNV-1a, as BlackboardLocal, with the finalizer of MurmurHash3:
+        // the low bits select the slot
+        uint64_t h = 14695981039346656037ULL;
+        for(std::size_t i=0; i<size; i++) {
+            h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    bool matches(const Slot& slot, const std::string& key) const
+    {
+        return slot.key_size == key.size() &&
+               memcmp( keys_.data() + slot.key_offset, key.data(), key.size() ) == 0;
+    }
+
+    // Slot of "key", or the empty slot where it would be inserted.
+    std::size_t probe(const std::string& key) const
+    {
+        const std::size_t mask = slots_.size() - 1;
+        std::size_t index = hash( key.data(), key.size() ) & mask;
+        while( slots_[index].key_offset != EMPTY_SLOT && !matches(slots_[index], key) )
+        {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    const Slot* find(const std::string& key) const
+    {
+        const Slot& slot = slots_[ probe(key) ];
+        return slot.key_offset == EMPTY_SLOT ? nullptr : &slot;
+    }
+
+    SafeAny::CompactAny& insert(const std::string& key)
+    {
+        std::size_t index = probe(key);
+        if( slots_[index].key_offset != EMPTY_SLOT ) { return slots_[index].value; }
+
+        if( (size_ + 1) * 4 > slots_.size() * 3 )
+        {
+            rehash( slots_.size() * 2 );
+            index = probe(key);
+        }
+        if( keys_.size() + key.size() >= EMPTY_SLOT ) {
+            throw std::runtime_error("BlackboardCompact: the keys exceed 4 GB");
+        }
+        Slot& slot = slots_[index];
+        slot.key_offset = static_cast<uint32_t>( keys_.size() );
+        slot.key_size = static_cast<uint32_t>( key.size() );
+        keys_.insert( keys_.end(), key.begin(), key.end() );
+        size_++;
+        return slot.value;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Slot> old( capacity );
+        old.swap( slots_ );
+        const std::size_t mask = capacity - 1;
+        for(Slot& slot: old)
+        {
+            if( slot.key_offset == EMPTY_SLOT ) { continue; }
+            std::size_t index = hash( keys_.data() + slot.key_offset, slot.key_size ) & mask;
+            while( slots_[index].key_offset != EMPTY_SLOT ) { index = (index + 1) & mask; }
+            slots_[index].key_offset = slot.key_offset;
+            slots_[index].key_size = slot.key_size;
+            slots_[index].value = std::move(slot.value);
+        }
+    }
+
+    std::vector<Slot> slots_;  // size: power of two, at most 3/4 full
+    std::vector<char> keys_;
+    std::size_t size_;
+    mutable SafeAny::Any scratch_;
+};
+
+
+#endif // BLACKBOARD_COMPACT_H
@@ -0,0 +1,286 @@
+#ifndef BLACKBOARD_CONCURRENT_H
+#define BLACKBOARD_CONCURRENT_H
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+#include "blackboard.h"
+
+// Thread-safe backend: the keys are partitioned into shards, each one protected
+// by its own mutex, so that threads working on different keys rarely contend.
+//
+// The values are copied out while the shard is locked, therefore the pointer
+// returned by get() refers to a per-thread copy and it is valid only until the
+// next call of get() from the same thread.
+//
+// getMany() and setMany() lock every shard at most once per call.
+//
+// Transactions are optimistic: every entry stores the version (a global counter)
+// of its last write. A transaction reads only entries not newer than its
+// snapshot, and commit() locks the shards involved, checks that the entries read
+// still have the same version and writes all the values with a new one.
+class BlackboardConcurrent: public BlackboardImpl
+{
+public:
+
+    // "shards" is rounded up to a power of two.
+    explicit BlackboardConcurrent(std::size_t shards = 16);
+
+    BlackboardConcurrent(const BlackboardConcurrent&) = delete;
+    BlackboardConcurrent& operator=(const BlackboardConcurrent&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override;
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override;
+
+    virtual void getMany(const std::string* keys, std::size_t count,
+                         SafeAny::Any* values, bool* found) const override;
+
+    virtual void setMany(const std::string* keys, const SafeAny::Any* values, std::size_t count) override;
+
+    virtual uint64_t snapshot() const override { return clock_.load(); }
+
+    virtual bool readVersioned(const std::string& key, uint64_t snapshot,
+                               BlackboardTransactionLog::Read& read) const override;
+
+    virtual bool commit(const BlackboardTransactionLog& log) override;
+
+    std::size_t shardCount() const { return shards_.size(); }
+
+private:
+
+    struct Entry
+    {
+        SafeAny::Any value;
+        uint64_t version;
+    };
+
+    typedef std::unordered_map<std::string, Entry> Storage;
+
+    // Each one in its own cache lines, to avoid false sharing of the mutexes.
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        Storage storage;
+
+        // before C++17, new ignores the alignment of the type
+        static void* operator new(std::size_t size)
+        {
+            void* ptr = nullptr;
+            if( posix_memalign( &ptr, alignof(Shard), size ) != 0 ) { throw std::bad_alloc(); }
+            return ptr;
+        }
+        static void operator delete(void* ptr) { std::free(ptr); }
+    };
+
+    // FNV-1a of the whole key: keys that differ anywhere (e.g. "robot_1/pose" and
+    // "robot_2/pose") go to different shards. The high bits select the shard.
+    std::size_t shardIndex(const std::string& key) const
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for(char c: key) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        hash *= 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>( hash >> 40 ) & mask_;
+    }
+
+    // Calls func(shard, indexes, size) once per shard, with the shard locked and
+    // the indexes of the keys that belong to it.
+    template <typename Func>
+    void forEachShard(const std::string* keys, std::size_t count, Func func) const;
+
+    // To be called with the shard locked.
+    void write(Shard& shard, const std::string& key, const SafeAny::Any& value, uint64_t version)
+    {
+        Entry& entry = shard.storage[key];
+        entry.value = value;
+        entry.version = version;
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t mask_;
+    std::atomic<uint64_t> clock_;
+};
+
+//----------------------------------------------------------
+
+inline BlackboardConcurrent::BlackboardConcurrent(std::size_t shards):
+    clock_(0)
+{
+    std::size_t size = 1;
+    while( size < shards ) { size *= 2; }
+    mask_ = size - 1;
+
+    shards_.reserve(size);
+    for(std::size_t i=0; i<size; i++){
+        shards_.emplace_back( new Shard );
+    }
+}
+
+inline const SafeAny::Any* BlackboardConcurrent::get(const std::string& key) const
+{
+    static thread_local SafeAny::Any copy;
+
+    const Shard& shard = *shards_[ shardIndex(key) ];
+    std::lock_guard<std::mutex> lock( shard.mutex );
+    auto it = shard.storage.find(key);
+    if( it == shard.storage.end() ){ return nullptr; }
+    copy = it->second.value;
+    return &copy;
+}
+
+inline void BlackboardConcurrent::set(const std::string& key, const SafeAny::Any& value)
+{
+    Shard& shard = *shards_[ shardIndex(key) ];
+    std::lock_guard<std::mutex> lock( shard.mutex );
+    write( shard, key, value, ++clock_ );
+}
+
+template <typename Func>
+inline void BlackboardConcurrent::forEachShard(const std::string* keys, std::size_t count, Func func) const
+{
+    const std::size_t DONE = std::size_t(-1);
+
+    // batches are usually small: avoid the allocation
+    std::size_t local_buffer[64];
+    std::vector<std::size_t> heap_buffer;
+    std::size_t* shard_of = local_buffer;
+    if( count > 32 )
+    {
+        heap_buffer.resize( 2*count );
+        shard_of = heap_buffer.data();
+    }
+    std::size_t* group = shard_of + count;
+
+    for(std::size_t i=0; i<count; i++)
+    {
+        shard_of[i] = shardIndex( keys[i] );
+        __builtin_prefetch( shards_[ shard_of[i] ].get() );
+    }
+
+    for(std::size_t i=0; i<count; i++)
+    {
+        const std::size_t current = shard_of[i];
+        if( current == DONE ) { continue; }
+
+        std::size_t group_size = 0;
+        for(std::size_t j=i; j<count; j++)
+        {
+            if( shard_of[j] == current )
+            {
+                group[group_size++] = j;
+                shard_of[j] = DONE;
+            }
+        }
+        Shard& shard = *shards_[current];
+        std::lock_guard<std::mutex> lock( shard.mutex );
+        func( shard, group, group_size );
+    }
+}
+
+inline void BlackboardConcurrent::getMany(const std::string* keys, std::size_t count,
+                                          SafeAny::Any* values, bool* found) const
+{
+    const SafeAny::Any* local_entries[32];
+    std::vector<const SafeAny::Any*> heap_entries;
+    const SafeAny::Any** entries = local_entries;
+    if( count > 32 )
+    {
+        heap_entries.resize(count);
+        entries = heap_entries.data();
+    }
+
+    forEachShard( keys, count, [&](Shard& shard, const std::size_t* group, std::size_t size)
+    {
+        // resolve all the keys of the shard and prefetch the values first, then
+        // copy them: the cache misses of different entries overlap.
+        for(std::size_t k=0; k<size; k++)
+        {
+            const std::size_t i = group[k];
+            auto it = shard.storage.find( keys[i] );
+            entries[i] = ( it == shard.storage.end() ) ? nullptr : &(it->second.value);
+            if( entries[i] ) { __builtin_prefetch( entries[i] ); }
+        }
+        for(std::size_t k=0; k<size; k++)
+        {
+            const std::size_t i = group[k];
+            found[i] = ( entries[i] != nullptr );
+            if( found[i] ) { values[i] = *entries[i]; }
+        }
+    } );
+}
+
+inline void BlackboardConcurrent::setMany(const std::string* keys, const SafeAny::Any* values, std::size_t count)
+{
+    forEachShard( keys, count, [&](Shard& shard, const std::size_t* group, std::size_t size)
+    {
+        const uint64_t version = ++clock_;
+        for(std::size_t k=0; k<size; k++){
+            write( shard, keys[group[k]], values[group[k]], version );
+        }
+    } );
+}
+
+inline bool BlackboardConcurrent::readVersioned(const std::string& key, uint64_t snapshot,
+                                                BlackboardTransactionLog::Read& read) const
+{
+    const Shard& shard = *shards_[ shardIndex(key) ];
+    std::lock_guard<std::mutex> lock( shard.mutex );
+
+    read.key = key;
+    auto it = shard.storage.find(key);
+    if( it == shard.storage.end() )
+    {
+        read.version = 0;
+        read.found = false;
+        return true;
+    }
+    if( it->second.version > snapshot ) { return false; }
+
+    read.version = it->second.version;
+    read.found = true;
+    read.value = it->second.value;
+    return true;
+}
+
+inline bool BlackboardConcurrent::commit(const BlackboardTransactionLog& log)
+{
+    // lock all the shards involved, in ascending order to avoid deadlocks
+    std::vector<std::size_t> indexes;
+    indexes.reserve( log.reads.size() + log.writes.size() );
+    for(const auto& read: log.reads)   { indexes.push_back( shardIndex(read.key) ); }
+    for(const auto& write: log.writes) { indexes.push_back( shardIndex(write.key) ); }
+    std::sort( indexes.begin(), indexes.end() );
+    indexes.erase( std::unique( indexes.begin(), indexes.end() ), indexes.end() );
+
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve( indexes.size() );
+    for(std::size_t index: indexes) {
+        locks.emplace_back( shards_[index]->mutex );
+    }
+
+    for(const auto& read: log.reads)
+    {
+        const Storage& storage = shards_[ shardIndex(read.key) ]->storage;
+        auto it = storage.find( read.key );
+        const bool found = ( it != storage.end() );
+        if( found != read.found || (found && it->second.version != read.version) ){
+            return false;
+        }
+    }
+
+    const uint64_t version = ++clock_;
+    for(const auto& write: log.writes) {
+        this->write( *shards_[ shardIndex(write.key) ], write.key, write.value, version );
+    }
+    return true;
+}
+
+
+#endif // BLACKBOARD_CONCURRENT_H
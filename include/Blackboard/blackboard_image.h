@@ -0,0 +1,436 @@
+#ifndef BLACKBOARD_IMAGE_H
+#define BLACKBOARD_IMAGE_H
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "blackboard.h"
+#include "SafeAny/type_tag.hpp"
+
+// Read-only blackboard stored in a binary image that is mmap-ed by the processes.
+//
+// The image is created once with BlackboardImageWriter; opening it costs a mmap()
+// and a pass over the entries to validate their offsets and, since the pages come
+// from the page cache, N processes using the same image share the same physical memory.
+//
+// get() can be called by several threads.
+//
+// Layout of the file (all the sections are aligned to 64 bytes):
+//
+//   Header
+//   int32_t displacement[buckets]  -> perfect hash index (hash and displace)
+//   Entry   entries[count]         -> fixed size, 16 bytes each
+//   data                           -> keys and strings
+//
+// Only numbers and strings can be stored.
+namespace BlackboardImageFormat
+{
+
+static const char MAGIC[8] = {'B','B','I','M','A','G','E','1'};
+
+struct Header
+{
+    char     magic[8];
+    uint32_t count;
+    uint32_t buckets;
+    uint64_t displacement_offset;
+    uint64_t entries_offset;
+    uint64_t data_offset;
+    uint64_t total_size;
+};
+
+struct Entry
+{
+    uint64_t value;       // raw bits of a number, or (offset | size<<32) of a string
+    uint32_t key_offset;  // offset in the data section
+    uint16_t key_size;
+    uint8_t  type;        // SafeAny::TypeTag
+    uint8_t  padding;
+};
+
+inline uint64_t hash(const char* data, std::size_t size, uint64_t seed)
+{
+    uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (std::size_t i=0; i<size; i++) {
+        h = (h ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+    // finalizer of MurmurHash3, FNV alone is a poor hash modulo small numbers
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb3fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t alignTo64(uint64_t offset)
+{
+    return (offset + 63) & ~uint64_t(63);
+}
+
+} // end namespace BlackboardImageFormat
+
+
+// Collects the values and writes the image.
+class BlackboardImageWriter
+{
+public:
+
+    template <typename T> void set(const std::string& key, const T& value)
+    {
+        setAny(key, SafeAny::Any(value));
+    }
+
+    void set(const std::string& key, const char* value)
+    {
+        setAny(key, SafeAny::Any(std::string(value)));
+    }
+
+    void setAny(const std::string& key, const SafeAny::Any& value)
+    {
+        const SafeAny::TypeTag tag = SafeAny::getTypeTag( value );
+        if( !SafeAny::isNumber(tag) && tag != SafeAny::TypeTag::STRING ){
+            throw std::runtime_error("BlackboardImageWriter: only numbers and strings can be stored");
+        }
+        if( key.size() > 0xFFFF ){
+            throw std::runtime_error("BlackboardImageWriter: key too long");
+        }
+        values_[key] = value;
+    }
+
+    std::size_t size() const { return values_.size(); }
+
+    // The file is written with a different name and then renamed, to
+    // avoid touching an image that might be mapped by other processes.
+    void save(const std::string& filename) const;
+
+private:
+    std::map<std::string, SafeAny::Any> values_;
+};
+
+
+class BlackboardImage: public BlackboardImpl
+{
+public:
+
+    BlackboardImage(const std::string& filename);
+
+    virtual ~BlackboardImage() override;
+
+    BlackboardImage(const BlackboardImage&) = delete;
+    BlackboardImage& operator=(const BlackboardImage&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override;
+
+    virtual void set(const std::string& key, const SafeAny::Any&) override
+    {
+        throw std::runtime_error("BlackboardImage is read-only, can't set " + key);
+    }
+
+    std::size_t size() const { return header_->count; }
+
+private:
+    typedef BlackboardImageFormat::Entry Entry;
+
+    const char* base_;
+    std::size_t mapped_size_;
+    const BlackboardImageFormat::Header* header_;
+    const int32_t* displacement_;
+    const Entry* entries_;
+    const char* data_;
+
+    bool validEntries() const;
+
+    // Values are converted to SafeAny::Any only the first time they are read:
+    // cache_[i] is written once, under cache_mutex_, before setting decoded_[i].
+    mutable std::vector<SafeAny::Any> cache_;
+    mutable std::vector<std::atomic<bool>> decoded_;
+    mutable std::mutex cache_mutex_;
+};
+
+//----------------------------------------------------------
+
+inline void BlackboardImageWriter::save(const std::string& filename) const
+{
+    using namespace BlackboardImageFormat;
+
+    const uint32_t count = static_cast<uint32_t>(values_.size());
+    const uint32_t buckets = count/2 + 1;
+
+    std::vector<const std::string*> keys;
+    std::vector<const SafeAny::Any*> values;
+    for(const auto& it: values_)
+    {
+        keys.push_back( &it.first );
+        values.push_back( &it.second );
+    }
+
+    //------ perfect hash: hash and displace -------
+    std::vector< std::vector<uint32_t> > bucket_keys( buckets );
+    for (uint32_t i=0; i<count; i++)
+    {
+        const uint64_t h = hash( keys[i]->data(), keys[i]->size(), 0 );
+        bucket_keys[ h % buckets ].push_back(i);
+    }
+
+    std::vector<uint32_t> order( buckets );
+    for (uint32_t b=0; b<buckets; b++) { order[b] = b; }
+    std::stable_sort( order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+        return bucket_keys[a].size() > bucket_keys[b].size();
+    });
+
+    std::vector<int32_t> displacement( buckets, 0 );
+    std::vector<uint32_t> slot_to_key( count );
+    std::vector<bool> taken( count, false );
+    std::vector<uint32_t> candidate;
+    uint32_t next_free = 0;
+
+    for(uint32_t b: order)
+    {
+        const auto& bucket = bucket_keys[b];
+        if( bucket.empty() ) { break; }
+
+        if( bucket.size() == 1 )
+        {
+            // no need to search: negative displacement means "this slot, directly"
+            while( taken[next_free] ) { next_free++; }
+            taken[next_free] = true;
+            slot_to_key[next_free] = bucket.front();
+            displacement[b] = -static_cast<int32_t>(next_free) - 1;
+            continue;
+        }
+
+        bool found = false;
+        for (int32_t d=1; d < 0x7FFFFFFF && !found; d++)
+        {
+            candidate.clear();
+            for (uint32_t k: bucket)
+            {
+                const uint32_t slot = hash( keys[k]->data(), keys[k]->size(), d ) % count;
+                if( taken[slot] ||
+                    std::find(candidate.begin(), candidate.end(), slot) != candidate.end() ){
+                    break;
+                }
+                candidate.push_back( slot );
+            }
+            if( candidate.size() == bucket.size() )
+            {
+                for (std::size_t i=0; i<bucket.size(); i++)
+                {
+                    taken[ candidate[i] ] = true;
+                    slot_to_key[ candidate[i] ] = bucket[i];
+                }
+                displacement[b] = d;
+                found = true;
+            }
+        }
+        if( !found ){
+            throw std::runtime_error("BlackboardImageWriter: can't build the perfect hash");
+        }
+    }
+
+    //------ serialize -------
+    std::vector<Entry> entries( count );
+    std::string data;
+
+    for (uint32_t slot=0; slot<count; slot++)
+    {
+        const std::string& key = *keys[ slot_to_key[slot] ];
+        const SafeAny::Any& value = *values[ slot_to_key[slot] ];
+        const SafeAny::TypeTag tag = SafeAny::getTypeTag( value );
+
+        Entry& entry = entries[slot];
+        memset( &entry, 0, sizeof(Entry) );
+        entry.type = static_cast<uint8_t>(tag);
+        entry.key_size = static_cast<uint16_t>(key.size());
+        entry.key_offset = static_cast<uint32_t>(data.size());
+        data.append( key );
+
+        if( tag == SafeAny::TypeTag::STRING )
+        {
+            const std::string str = value.extract<std::string>();
+            // strings are aligned to 8 bytes
+            data.resize( (data.size() + 7) & ~std::size_t(7), '\0' );
+            entry.value = uint64_t(data.size()) | (uint64_t(str.size()) << 32);
+            data.append( str );
+        }
+        else{
+            entry.value = SafeAny::numberToBits(value, tag);
+        }
+        if( data.size() > 0xFFFFFFFFull ){
+            throw std::runtime_error("BlackboardImageWriter: image too large");
+        }
+    }
+
+    Header header;
+    memset( &header, 0, sizeof(Header) );
+    memcpy( header.magic, MAGIC, sizeof(MAGIC) );
+    header.count = count;
+    header.buckets = buckets;
+    header.displacement_offset = alignTo64( sizeof(Header) );
+    header.entries_offset = alignTo64( header.displacement_offset + buckets*sizeof(int32_t) );
+    header.data_offset = alignTo64( header.entries_offset + count*sizeof(Entry) );
+    header.total_size = header.data_offset + data.size();
+
+    std::string image( header.total_size, '\0' );
+    memcpy( &image[0], &header, sizeof(Header) );
+    memcpy( &image[header.displacement_offset], displacement.data(), buckets*sizeof(int32_t) );
+    if( count > 0 ){
+        memcpy( &image[header.entries_offset], entries.data(), count*sizeof(Entry) );
+    }
+    if( !data.empty() ){
+        memcpy( &image[header.data_offset], data.data(), data.size() );
+    }
+
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream file( tmp_filename, std::ios::binary | std::ios::trunc );
+        file.write( image.data(), static_cast<std::streamsize>(image.size()) );
+        if( !file ){
+            throw std::runtime_error("BlackboardImageWriter: can't write " + tmp_filename);
+        }
+    }
+    if( std::rename( tmp_filename.c_str(), filename.c_str() ) != 0 ){
+        throw std::runtime_error("BlackboardImageWriter: can't rename " + tmp_filename);
+    }
+}
+
+inline BlackboardImage::BlackboardImage(const std::string& filename):
+    base_(nullptr), mapped_size_(0)
+{
+    using namespace BlackboardImageFormat;
+
+    int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 ){
+        throw std::runtime_error("BlackboardImage: can't open " + filename);
+    }
+    struct stat st;
+    if( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header)) ){
+        close(fd);
+        throw std::runtime_error("BlackboardImage: invalid file " + filename);
+    }
+    mapped_size_ = static_cast<std::size_t>(st.st_size);
+
+    void* ptr = mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( ptr == MAP_FAILED ){
+        throw std::runtime_error("BlackboardImage: can't map " + filename);
+    }
+    base_ = static_cast<const char*>(ptr);
+    header_ = reinterpret_cast<const Header*>(base_);
+
+    const bool valid = memcmp( header_->magic, MAGIC, sizeof(MAGIC) ) == 0 &&
+            header_->total_size == mapped_size_ &&
+            header_->buckets > 0 &&
+            header_->displacement_offset >= sizeof(Header) &&
+            header_->displacement_offset % alignof(int32_t) == 0 &&
+            header_->entries_offset % alignof(Entry) == 0 &&
+            header_->displacement_offset + uint64_t(header_->buckets)*sizeof(int32_t) <= header_->entries_offset &&
+            header_->entries_offset + uint64_t(header_->count)*sizeof(Entry) <= header_->data_offset &&
+            header_->data_offset <= header_->total_size;
+    if( !valid ){
+        munmap( ptr, mapped_size_ );
+        throw std::runtime_error("BlackboardImage: invalid file " + filename);
+    }
+
+    displacement_ = reinterpret_cast<const int32_t*>( base_ + header_->displacement_offset );
+    entries_ = reinterpret_cast<const Entry*>( base_ + header_->entries_offset );
+    data_ = base_ + header_->data_offset;
+
+    if( !validEntries() ){
+        munmap( ptr, mapped_size_ );
+        throw std::runtime_error("BlackboardImage: corrupted file " + filename);
+    }
+    cache_.resize( header_->count );
+    decoded_ = std::vector<std::atomic<bool>>( header_->count );
+}
+
+// The keys and the strings must be inside the data section, and a negative
+// displacement must point to an existing slot, so that get() doesn't need to
+// check them.
+inline bool BlackboardImage::validEntries() const
+{
+    for (uint32_t b=0; b < header_->buckets; b++)
+    {
+        const int64_t d = displacement_[b];
+        if( d < 0 && -d - 1 >= int64_t(header_->count) ) { return false; }
+    }
+
+    const uint64_t data_size = header_->total_size - header_->data_offset;
+    for (uint32_t i=0; i < header_->count; i++)
+    {
+        const Entry& entry = entries_[i];
+        if( uint64_t(entry.key_offset) + entry.key_size > data_size ) { return false; }
+
+        const SafeAny::TypeTag tag = static_cast<SafeAny::TypeTag>(entry.type);
+        if( tag == SafeAny::TypeTag::STRING )
+        {
+            const uint64_t offset = static_cast<uint32_t>( entry.value );
+            const uint64_t size = static_cast<uint32_t>( entry.value >> 32 );
+            if( offset + size > data_size ) { return false; }
+        }
+        else if( !SafeAny::isNumber(tag) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline BlackboardImage::~BlackboardImage()
+{
+    munmap( const_cast<char*>(base_), mapped_size_ );
+}
+
+inline const SafeAny::Any* BlackboardImage::get(const std::string& key) const
+{
+    using namespace BlackboardImageFormat;
+
+    const uint32_t count = header_->count;
+    if( count == 0 ) { return nullptr; }
+
+    const uint64_t h = hash( key.data(), key.size(), 0 );
+    const int32_t d = displacement_[ h % header_->buckets ];
+    const uint32_t index = (d < 0) ? static_cast<uint32_t>( -(d + 1) ) :
+                                     static_cast<uint32_t>( hash( key.data(), key.size(), d ) % count );
+    if( index >= count ) { return nullptr; }
+
+    const Entry& entry = entries_[index];
+    if( entry.key_size != key.size() ||
+        memcmp( data_ + entry.key_offset, key.data(), key.size() ) != 0 )
+    {
+        return nullptr;
+    }
+
+    SafeAny::Any& value = cache_[index];
+    if( decoded_[index].load(std::memory_order_acquire) ) { return &value; }
+
+    std::lock_guard<std::mutex> lock( cache_mutex_ );
+    if( !decoded_[index].load(std::memory_order_relaxed) )
+    {
+        const SafeAny::TypeTag tag = static_cast<SafeAny::TypeTag>(entry.type);
+        if( tag == SafeAny::TypeTag::STRING )
+        {
+            const uint32_t offset = static_cast<uint32_t>( entry.value );
+            const uint32_t size = static_cast<uint32_t>( entry.value >> 32 );
+            value = SafeAny::Any( std::string( data_ + offset, size ) );
+        }
+        else{
+            value = SafeAny::numberFromBits( tag, entry.value );
+        }
+        decoded_[index].store( true, std::memory_order_release );
+    }
+    return &value;
+}
+
+
+#endif // BLACKBOARD_IMAGE_H
@@ -1,30 +1,225 @@
 #ifndef BLACKBOARD_LOCAL_H
 #define BLACKBOARD_LOCAL_H
 
+#include <tuple>
+#include <stdexcept>
+#include <cstring>
 #include "blackboard.h"
+#include "SafeAny/memory_resource.hpp"
 
+// Simple key/value storage.
+//
+// All the memory (hash nodes, keys and values that don't fit into SafeAny::Any)
+// can be allocated from a linb::memory_resource, for instance a linb::arena_resource:
+// the whole blackboard lives in a few contiguous chunks, which are freed at once
+// when the arena is destroyed. The resource must outlive the blackboard.
+// Note that the buffers owned by the values themselves (e.g. the elements of a
+// std::vector) are still allocated by their own allocator.
+//
+// A value of the same type of the stored one is assigned in place, reusing its
+// memory (e.g. the capacity of a std::vector or the buffer of a string).
+//
+// Real-time mode: once all the keys have been created (with values as large as
+// they will ever be), setRealTime(true) makes set() throw std::runtime_error instead
+// of adding a key or changing the type of a value (numbers excepted).
+// A value of the same type is still assigned in place, which allocates if it
+// doesn't fit into the stored one (e.g. a longer std::vector), and emplace()
+// constructs a new value: these allocations are not refused, use AllocationMonitor
+// to detect them.
+//
+// With setConversionCache(true), every entry memoizes its last conversion to a number
+// (see SafeAny::ConversionCache): reading again a value stored as int32_t as a double
+// doesn't convert it again. The cache of an entry is cleared when its value changes.
 class BlackboardLocal: public BlackboardImpl
 {
 public:
 
-    BlackboardLocal() {}
+    explicit BlackboardLocal(linb::memory_resource* resource = nullptr):
+        storage_( 0, KeyHash(), KeyEqual(), Allocator(resource) ),
+        resource_(resource),
+        real_time_(false),
+        conversion_cache_(false)
+    {}
+
+    BlackboardLocal(const BlackboardLocal&) = delete;
+    BlackboardLocal& operator=(const BlackboardLocal&) = delete;
+
+    virtual ~BlackboardLocal() override
+    {
+        for(auto& it: storage_){
+            linb::detail::deallocate( resource_, const_cast<char*>(it.first.data), it.first.size + 1, 1 );
+        }
+    }
 
     virtual const SafeAny::Any* get(const std::string& key) const override
     {
-        auto it = storage_.find(key);
+        auto it = storage_.find( Key(key) );
+        if( it == storage_.end() ){ return nullptr; }
+        return &(it->second.value);
+    }
+
+    virtual const SafeAny::Any* getCached(const std::string& key, SafeAny::ConversionCache*& cache) const override
+    {
+        auto it = storage_.find( Key(key) );
         if( it == storage_.end() ){ return nullptr; }
-        return &(it->second);
+        cache = conversion_cache_ ? &(it->second.cache) : nullptr;
+        return &(it->second.value);
     }
 
     virtual void set(const std::string& key, const SafeAny::Any& value) override
     {
-        storage_[key] = value;
+        auto it = storage_.find( Key(key) );
+        if( real_time_ )
+        {
+            setRealTime(it, key, value);
+            return;
+        }
+        if( it != storage_.end() )
+        {
+            // same type: assign in place, reusing the memory of the current value
+            it->second.cache.clear();
+            if( !it->second.value.assignInPlace(value) ) {
+                it->second.value = SafeAny::Any( std::allocator_arg, resource_, value );
+            }
+            return;
+        }
+        insert( key, SafeAny::Any( std::allocator_arg, resource_, value ) );
+    }
+
+    // The value is moved into the storage, without copies (also move-only types).
+    // With a resource the copyable values are copied into it instead, as above: only
+    // the move-only ones keep their own memory.
+    // In real-time mode the value is copied into the preallocated one, as above.
+    virtual void set(const std::string& key, SafeAny::Any&& value) override
+    {
+        if( resource_ && value.isCopyable() )
+        {
+            set( key, static_cast<const SafeAny::Any&>(value) );
+            return;
+        }
+        auto it = storage_.find( Key(key) );
+        if( real_time_ )
+        {
+            setRealTime(it, key, value);
+            return;
+        }
+        if( it != storage_.end() )
+        {
+            it->second.cache.clear();
+            it->second.value = std::move(value);
+            return;
+        }
+        insert( key, std::move(value) );
+    }
+
+    // The caller may modify the value: its cache is cleared.
+    virtual SafeAny::Any* slot(const std::string& key) override
+    {
+        auto it = storage_.find( Key(key) );
+        if( it == storage_.end() ){ return nullptr; }
+        it->second.cache.clear();
+        return &(it->second.value);
+    }
+
+    // Preallocate the buckets for "count" keys.
+    void reserve(std::size_t count) { storage_.reserve(count); }
+
+    void setRealTime(bool enable) { real_time_ = enable; }
+
+    bool realTime() const { return real_time_; }
+
+    // Memoize the conversions of the numbers done by the front-ends (tryGet() and get()).
+    void setConversionCache(bool enable)
+    {
+        conversion_cache_ = enable;
+        for(auto& it: storage_) { it.second.cache.clear(); }
     }
 
+    bool conversionCache() const { return conversion_cache_; }
+
+    linb::memory_resource* resource() const { return resource_; }
 
 private:
-    std::unordered_map<std::string, SafeAny::Any> storage_;
 
+    // The map refers to the copies of the keys, allocated from the resource,
+    // and get() looks them up without creating any string.
+    struct Key
+    {
+        explicit Key(const std::string& str): data(str.data()), size(str.size()) {}
+        Key(const char* ptr, std::size_t len): data(ptr), size(len) {}
+
+        const char* data;
+        std::size_t size;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            // FNV-1a
+            uint64_t hash = 14695981039346656037ULL;
+            for(std::size_t i=0; i<key.size; i++) {
+                hash = (hash ^ static_cast<unsigned char>(key.data[i])) * 1099511628211ULL;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const Key& a, const Key& b) const
+        {
+            return a.size == b.size && std::memcmp(a.data, b.data, a.size) == 0;
+        }
+    };
+
+    struct Entry
+    {
+        explicit Entry(SafeAny::Any&& val): value( std::move(val) ) {}
+
+        SafeAny::Any value;
+        // mutable: filled by the reads
+        mutable SafeAny::ConversionCache cache;
+    };
+
+    typedef linb::resource_allocator< std::pair<const Key, Entry> > Allocator;
+
+    typedef std::unordered_map<Key, Entry, KeyHash, KeyEqual, Allocator> Storage;
+
+    void setRealTime(Storage::iterator it, const std::string& key, const SafeAny::Any& value)
+    {
+        if( it == storage_.end() ){
+            throw std::runtime_error("BlackboardLocal: can't add the key [" + key + "] in real-time mode");
+        }
+        it->second.cache.clear();
+        if( it->second.value.assignInPlace(value) ) { return; }
+        if( !value.isArithmetic() ){
+            throw std::runtime_error("BlackboardLocal: changing the type of [" + key +
+                                     "] would allocate memory in real-time mode");
+        }
+        it->second.value = value;
+    }
+
+    void insert(const std::string& key, SafeAny::Any&& value)
+    {
+        char* data = static_cast<char*>( linb::detail::allocate( resource_, key.size() + 1, 1 ) );
+        std::memcpy( data, key.c_str(), key.size() + 1 );
+        try{
+            storage_.emplace( std::piecewise_construct,
+                              std::forward_as_tuple( data, key.size() ),
+                              std::forward_as_tuple( std::move(value) ) );
+        }
+        catch(...)
+        {
+            linb::detail::deallocate( resource_, data, key.size() + 1, 1 );
+            throw;
+        }
+    }
+
+    Storage storage_;
+    linb::memory_resource* resource_;
+    bool real_time_;
+    bool conversion_cache_;
 };
 
 
@@ -0,0 +1,221 @@
+#ifndef BLACKBOARD_PLUGIN_H
+#define BLACKBOARD_PLUGIN_H
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <dlfcn.h>
+#include <dirent.h>
+
+#include "blackboard.h"
+
+// Backends can be compiled into shared libraries and loaded at run-time,
+// so that their dependencies (SQLite, ROS, etc.) are not linked by the core.
+//
+// A plugin registers its factories in its entry point:
+//
+//   BLACKBOARD_PLUGIN_ENTRY_POINT(registry)
+//   {
+//       registry.add("sqlite", [](const std::string& params) -> BlackboardImpl* {
+//           return new BlackboardSqlite(params);
+//       });
+//   }
+//
+// The application loads the plugins with BlackboardPluginLoader and creates the
+// backends by name.
+//
+// Values stored in SafeAny::Any can be exchanged between the application and the
+// plugins: the type checks of linb::any compare std::type_info by address first
+// and fall back to the comparison of the names, because each shared library
+// might have its own copy of the type_info of the same type.
+
+#define BLACKBOARD_PLUGIN_ABI_VERSION 1
+
+class BlackboardPluginRegistry
+{
+public:
+    typedef std::function<BlackboardImpl*(const std::string& params)> Factory;
+
+    void add(const std::string& name, Factory factory)
+    {
+        if( factories_.count(name) ){
+            throw std::runtime_error("BlackboardPluginRegistry: backend already registered: " + name);
+        }
+        factories_.insert( {name, std::move(factory)} );
+    }
+
+    // Backend with a constructor that takes no parameters.
+    template <typename T> void add(const std::string& name)
+    {
+        add(name, [](const std::string&) -> BlackboardImpl* { return new T(); });
+    }
+
+    bool contains(const std::string& name) const
+    {
+        return factories_.count(name) != 0;
+    }
+
+    std::vector<std::string> names() const
+    {
+        std::vector<std::string> out;
+        for(const auto& it: factories_) { out.push_back(it.first); }
+        return out;
+    }
+
+    // Add all the factories of "other", or none of them if any name is already registered.
+    void merge(BlackboardPluginRegistry&& other)
+    {
+        for(const auto& it: other.factories_)
+        {
+            if( factories_.count(it.first) ){
+                throw std::runtime_error("BlackboardPluginRegistry: backend already registered: " + it.first);
+            }
+        }
+        for(auto& it: other.factories_) { factories_.insert( {it.first, std::move(it.second)} ); }
+        other.factories_.clear();
+    }
+
+    std::unique_ptr<BlackboardImpl> create(const std::string& name, const std::string& params = std::string()) const
+    {
+        auto it = factories_.find(name);
+        if( it == factories_.end() ){
+            throw std::runtime_error("BlackboardPluginRegistry: unknown backend: " + name);
+        }
+        return std::unique_ptr<BlackboardImpl>( it->second(params) );
+    }
+
+private:
+    std::map<std::string, Factory> factories_;
+};
+
+#define BLACKBOARD_PLUGIN_ENTRY_POINT(registry) \
+    extern "C" __attribute__((visibility("default"))) int blackboard_plugin_abi_version() \
+    { return BLACKBOARD_PLUGIN_ABI_VERSION; } \
+    extern "C" __attribute__((visibility("default"))) \
+    void blackboard_plugin_register(BlackboardPluginRegistry& registry)
+
+
+// Loads the plugins and keeps the registry of all their factories.
+//
+// The libraries are never unloaded: the backends they create (and the values
+// these backends return) use their code until the very end of the process.
+class BlackboardPluginLoader: public BlackboardPluginRegistry
+{
+public:
+
+    // Load a single shared library. Throws if it is not a valid plugin, if it was
+    // built for a different ABI version or if it registers a backend with the name
+    // of one already registered: in that case none of its backends is registered.
+    void load(const std::string& filename)
+    {
+        // RTLD_LOCAL: the symbols of different plugins must not interfere
+        void* handle = dlopen( filename.c_str(), RTLD_NOW | RTLD_LOCAL );
+        if( !handle ){
+            throw std::runtime_error("BlackboardPluginLoader: " + std::string(dlerror()) );
+        }
+        if( !dlsym(handle, "blackboard_plugin_register") )
+        {
+            dlclose(handle);
+            throw std::runtime_error("BlackboardPluginLoader: " + filename + " is not a blackboard plugin");
+        }
+        registerPlugin(handle, filename);
+    }
+
+    // Load all the plugins (files with extension .so) in a directory.
+    // Shared libraries which are not plugins are skipped; so are the libraries that
+    // can't be loaded and the plugins that load() would refuse, whose errors are
+    // appended to "errors" (if not nullptr).
+    // Returns the number of plugins loaded.
+    std::size_t loadDirectory(const std::string& directory, std::vector<std::string>* errors = nullptr)
+    {
+        DIR* dir = opendir( directory.c_str() );
+        if( !dir ){
+            throw std::runtime_error("BlackboardPluginLoader: can't open directory " + directory);
+        }
+        std::vector<std::string> files;
+        while( dirent* entry = readdir(dir) )
+        {
+            const std::string name( entry->d_name );
+            if( name.size() > 3 && name.compare( name.size()-3, 3, ".so" ) == 0 ){
+                files.push_back( directory + "/" + name );
+            }
+        }
+        closedir(dir);
+
+        std::size_t loaded = 0;
+        for(const auto& file: files)
+        {
+            void* handle = dlopen( file.c_str(), RTLD_NOW | RTLD_LOCAL );
+            if( !handle )
+            {
+                if( errors ) { errors->push_back( "BlackboardPluginLoader: " + std::string(dlerror()) ); }
+                continue;
+            }
+            if( !dlsym(handle, "blackboard_plugin_register") )
+            {
+                dlclose(handle);
+                continue;
+            }
+            try{
+                registerPlugin(handle, file);
+                loaded++;
+            }
+            catch(std::exception& err)
+            {
+                if( errors ) { errors->push_back( err.what() ); }
+            }
+        }
+        return loaded;
+    }
+
+    const std::vector<std::string>& libraries() const { return libraries_; }
+
+private:
+
+    void registerPlugin(void* handle, const std::string& filename)
+    {
+        typedef int (*VersionFunction)();
+        typedef void (*RegisterFunction)(BlackboardPluginRegistry&);
+
+        auto version = reinterpret_cast<VersionFunction>( dlsym(handle, "blackboard_plugin_abi_version") );
+        auto register_backends = reinterpret_cast<RegisterFunction>( dlsym(handle, "blackboard_plugin_register") );
+
+        if( !version || version() != BLACKBOARD_PLUGIN_ABI_VERSION ){
+            dlclose(handle);
+            throw std::runtime_error("BlackboardPluginLoader: " + filename + " was built for a different ABI version");
+        }
+        // The exceptions thrown by the plugin may have their type, what() and destructor
+        // in the library: the message is copied and the library closed only once the
+        // exception is destroyed.
+        bool failed = false;
+        std::string error;
+        try{
+            // all the backends or none: the factories are collected apart first
+            BlackboardPluginRegistry plugin;
+            register_backends( plugin );
+            merge( std::move(plugin) );
+        }
+        catch(std::exception& err)
+        {
+            failed = true;
+            error = err.what();
+        }
+        catch(...)
+        {
+            failed = true;
+            error = "unknown exception";
+        }
+        if( failed )
+        {
+            dlclose(handle);
+            throw std::runtime_error("BlackboardPluginLoader: can't register " + filename + ": " + error);
+        }
+        libraries_.push_back( filename );
+    }
+
+    std::vector<std::string> libraries_;
+};
+
+
+#endif // BLACKBOARD_PLUGIN_H
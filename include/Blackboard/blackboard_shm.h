@@ -0,0 +1,443 @@
+#ifndef BLACKBOARD_SHM_H
+#define BLACKBOARD_SHM_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "blackboard.h"
+#include "SafeAny/type_tag.hpp"
+
+// Backend that lives in a POSIX shared-memory segment, so that several
+// processes can share the same blackboard without any external service.
+//
+// The segment contains a fixed-capacity open addressing hash table. Nothing
+// inside the segment is a pointer: slots are addressed by index and strings
+// by offset into a pool, so every process can map it at a different address.
+//
+// - Writers are serialized by a robust, process-shared mutex (a writer that
+//   dies while holding it does not block the others forever; the value it was
+//   writing is lost, as if the key was missing).
+// - Readers never take the mutex: each slot is protected by a seqlock, so a
+//   get() from another process is just a memory read.
+// - In the same process, get() and set() can be called by several threads.
+//
+// Only arithmetic types and strings (SimpleString) can be stored, because
+// their layout is fixed and does not depend on the address space.
+class BlackboardShm: public BlackboardImpl
+{
+public:
+
+    static const std::size_t MAX_KEY_SIZE = 63;
+
+    // How long the constructor waits for the process that creates the segment.
+    static const int OPEN_TIMEOUT_MS = 1000;
+
+    // Open the segment called "name" (for instance "/my_blackboard"), creating it
+    // if it doesn't exist yet. The sizes are used only by the process that creates it.
+    // Throws if the segment is not initialized within OPEN_TIMEOUT_MS (its creator
+    // died: remove() it).
+    BlackboardShm(const std::string& name,
+                  std::size_t capacity = 1024,
+                  std::size_t string_pool_size = 64*1024);
+
+    virtual ~BlackboardShm() override;
+
+    BlackboardShm(const BlackboardShm&) = delete;
+    BlackboardShm& operator=(const BlackboardShm&) = delete;
+
+    // The returned pointer refers to a copy owned by this object and by the calling
+    // thread. It is valid until the next call of get() with the same key from the
+    // same thread.
+    virtual const SafeAny::Any* get(const std::string& key) const override;
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override;
+
+    std::size_t capacity() const { return header_->capacity; }
+
+    // Remove the segment from the system. Processes that have it mapped can still use it.
+    static void remove(const std::string& name)
+    {
+        shm_unlink( name.c_str() );
+    }
+
+private:
+
+    struct Header
+    {
+        uint64_t magic;
+        uint32_t capacity;   // number of slots, power of two
+        uint32_t pool_size;  // bytes available for strings
+        std::atomic<uint32_t> pool_used;
+        std::atomic<uint32_t> ready;
+        pthread_mutex_t mutex;
+    };
+
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence; // odd while a writer is modifying the value
+        std::atomic<uint32_t> used;     // set once, when the key is published
+        uint32_t hash;
+        uint16_t key_size;
+        uint8_t  type;
+        uint8_t  padding;
+        char     key[MAX_KEY_SIZE+1];
+        uint64_t value;        // raw bits of arithmetic types
+        uint32_t str_offset;   // offset in the string pool
+        uint32_t str_size;
+        uint32_t str_capacity;
+        uint32_t padding2;
+    };
+
+    static const uint64_t MAGIC = 0x424C4B42534D3031ull; // "BLKBSM01"
+
+    static uint32_t hashKey(const char* data, std::size_t size)
+    {
+        uint32_t h = 2166136261u; // FNV-1a
+        for (std::size_t i=0; i<size; i++) {
+            h = (h ^ static_cast<uint8_t>(data[i])) * 16777619u;
+        }
+        return h;
+    }
+
+    Slot* slots() const
+    {
+        return reinterpret_cast<Slot*>( reinterpret_cast<char*>(header_) + sizeof(Header) );
+    }
+
+    char* pool() const
+    {
+        return reinterpret_cast<char*>( slots() + header_->capacity );
+    }
+
+    // Index of the slot containing key, or of the empty slot where it should be inserted.
+    // Returns -1 if the key is not there and the table is full.
+    long findSlot(const std::string& key, uint32_t hash) const;
+
+    void lock();
+    void unlock() { pthread_mutex_unlock( &header_->mutex ); }
+
+    // Called with the mutex of a dead writer.
+    void repairSlots();
+
+    void writeValue(Slot& slot, const SafeAny::Any& value);
+
+    std::string name_;
+    Header* header_;
+    std::size_t mapped_size_;
+    // Copies returned by get(), one per slot and per thread. The mutex guards only
+    // the map: each vector is used by its own thread.
+    std::vector<SafeAny::Any>& threadCache() const;
+
+    mutable std::mutex caches_mutex_;
+    mutable std::unordered_map<std::thread::id, std::vector<SafeAny::Any>> caches_;
+};
+
+//----------------------------------------------------------
+
+inline BlackboardShm::BlackboardShm(const std::string& name,
+                                    std::size_t capacity,
+                                    std::size_t string_pool_size):
+    name_(name), header_(nullptr), mapped_size_(0)
+{
+    std::size_t slots_count = 16;
+    while( slots_count < capacity ) { slots_count *= 2; }
+
+    const int timeout_ms = OPEN_TIMEOUT_MS;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    auto timedOut = [&deadline]() { return std::chrono::steady_clock::now() > deadline; };
+
+    bool creator = true;
+    int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666 );
+    if( fd < 0 && errno == EEXIST )
+    {
+        creator = false;
+        fd = shm_open( name.c_str(), O_RDWR, 0666 );
+    }
+    if( fd < 0 ){
+        throw std::runtime_error("BlackboardShm: can't open shared memory " + name);
+    }
+
+    if( creator )
+    {
+        mapped_size_ = sizeof(Header) + slots_count*sizeof(Slot) + string_pool_size;
+        if( ftruncate(fd, static_cast<off_t>(mapped_size_)) != 0 ){
+            close(fd);
+            shm_unlink( name.c_str() );
+            throw std::runtime_error("BlackboardShm: can't resize shared memory " + name);
+        }
+    }
+    else{
+        // the creator might be still calling ftruncate()
+        struct stat st;
+        do{
+            if( fstat(fd, &st) != 0 ){
+                close(fd);
+                throw std::runtime_error("BlackboardShm: can't stat shared memory " + name);
+            }
+            if( st.st_size == 0 )
+            {
+                if( timedOut() ){
+                    close(fd);
+                    throw std::runtime_error("BlackboardShm: " + name + " was never initialized");
+                }
+                usleep(100);
+            }
+        } while( st.st_size == 0 );
+        mapped_size_ = static_cast<std::size_t>(st.st_size);
+    }
+
+    void* ptr = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if( ptr == MAP_FAILED ){
+        throw std::runtime_error("BlackboardShm: can't map shared memory " + name);
+    }
+    header_ = static_cast<Header*>(ptr);
+
+    if( creator )
+    {
+        // ftruncate already filled the segment with zeros
+        header_->magic = MAGIC;
+        header_->capacity = static_cast<uint32_t>(slots_count);
+        header_->pool_size = static_cast<uint32_t>(string_pool_size);
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header_->mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+
+        header_->ready.store(1, std::memory_order_release);
+    }
+    else{
+        while( header_->ready.load(std::memory_order_acquire) == 0 )
+        {
+            if( timedOut() ){
+                munmap(header_, mapped_size_);
+                throw std::runtime_error("BlackboardShm: " + name + " was never initialized");
+            }
+            usleep(100);
+        }
+        if( header_->magic != MAGIC ){
+            munmap(header_, mapped_size_);
+            throw std::runtime_error("BlackboardShm: " + name + " is not a blackboard");
+        }
+    }
+}
+
+inline BlackboardShm::~BlackboardShm()
+{
+    munmap(header_, mapped_size_);
+}
+
+inline void BlackboardShm::lock()
+{
+    int res = pthread_mutex_lock( &header_->mutex );
+    if( res == EOWNERDEAD )
+    {
+        // The previous owner died, maybe in the middle of writeValue()
+        repairSlots();
+        pthread_mutex_consistent( &header_->mutex );
+    }
+    else if( res != 0 ){
+        throw std::runtime_error("BlackboardShm: can't lock the shared memory");
+    }
+}
+
+inline void BlackboardShm::repairSlots()
+{
+    // A half-written slot has an odd sequence, that would make the readers wait
+    // forever. Its value might be torn: it is discarded and the sequence bumped.
+    Slot* table = slots();
+    for (uint32_t i=0; i < header_->capacity; i++)
+    {
+        Slot& slot = table[i];
+        const uint32_t seq = slot.sequence.load(std::memory_order_relaxed);
+        if( (seq & 1) == 0 ) { continue; }
+
+        slot.type = static_cast<uint8_t>(SafeAny::TypeTag::EMPTY);
+        slot.value = 0;
+        slot.str_size = 0;
+        slot.sequence.store(seq + 1, std::memory_order_release);
+    }
+}
+
+inline std::vector<SafeAny::Any>& BlackboardShm::threadCache() const
+{
+    std::lock_guard<std::mutex> lock( caches_mutex_ );
+    std::vector<SafeAny::Any>& cache = caches_[ std::this_thread::get_id() ];
+    if( cache.empty() ) { cache.resize( header_->capacity ); }
+    return cache;
+}
+
+inline long BlackboardShm::findSlot(const std::string& key, uint32_t hash) const
+{
+    const uint32_t mask = header_->capacity - 1;
+    Slot* table = slots();
+
+    for (uint32_t i=0; i <= mask; i++)
+    {
+        Slot& slot = table[ (hash + i) & mask ];
+        if( slot.used.load(std::memory_order_acquire) == 0 ){
+            return static_cast<long>( (hash + i) & mask );
+        }
+        if( slot.hash == hash && slot.key_size == key.size() &&
+            memcmp(slot.key, key.data(), key.size()) == 0 )
+        {
+            return static_cast<long>( (hash + i) & mask );
+        }
+    }
+    return -1;
+}
+
+inline const SafeAny::Any* BlackboardShm::get(const std::string& key) const
+{
+    if( key.size() > MAX_KEY_SIZE ) { return nullptr; }
+
+    const long index = findSlot(key, hashKey(key.data(), key.size()));
+    if( index < 0 ) { return nullptr; }
+
+    const Slot& slot = slots()[index];
+    if( slot.used.load(std::memory_order_acquire) == 0 ) { return nullptr; }
+
+    SafeAny::TypeTag type;
+    uint64_t bits;
+    std::string str;
+
+    uint32_t seq_begin, seq_end;
+    do{
+        seq_begin = slot.sequence.load(std::memory_order_acquire);
+        if( seq_begin & 1 ){
+            // a writer is here (or died here); wait for it.
+            sched_yield();
+            continue;
+        }
+        type = static_cast<SafeAny::TypeTag>(slot.type);
+        bits = slot.value;
+        if( type == SafeAny::TypeTag::STRING )
+        {
+            const uint32_t offset = slot.str_offset;
+            const uint32_t size = slot.str_size;
+            // check the bounds, the values might be torn by a concurrent writer
+            if( uint64_t(offset) + size <= header_->pool_size ){
+                str.assign( pool() + offset, size );
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = slot.sequence.load(std::memory_order_relaxed);
+    } while( (seq_begin & 1) || seq_begin != seq_end );
+
+    SafeAny::Any& out = threadCache()[index];
+    if( type == SafeAny::TypeTag::STRING ){
+        out = SafeAny::Any( str );
+    }
+    else if( SafeAny::isNumber(type) ){
+        out = SafeAny::numberFromBits(type, bits);
+    }
+    else{
+        return nullptr;
+    }
+    return &out;
+}
+
+inline void BlackboardShm::set(const std::string& key, const SafeAny::Any& value)
+{
+    if( key.size() > MAX_KEY_SIZE ){
+        throw std::runtime_error("BlackboardShm: key too long: " + key);
+    }
+    const uint32_t hash = hashKey(key.data(), key.size());
+
+    lock();
+    try{
+        const long index = findSlot(key, hash);
+        if( index < 0 ){
+            throw std::runtime_error("BlackboardShm: the blackboard is full");
+        }
+        Slot& slot = slots()[index];
+
+        if( slot.used.load(std::memory_order_relaxed) == 0 )
+        {
+            // Not visible to the readers yet. Publish the key after the value.
+            slot.hash = hash;
+            slot.key_size = static_cast<uint16_t>(key.size());
+            memcpy(slot.key, key.data(), key.size());
+            slot.key[key.size()] = '\0';
+            writeValue(slot, value);
+            slot.used.store(1, std::memory_order_release);
+        }
+        else{
+            writeValue(slot, value);
+        }
+    }
+    catch(...)
+    {
+        unlock();
+        throw;
+    }
+    unlock();
+}
+
+inline void BlackboardShm::writeValue(Slot& slot, const SafeAny::Any& value)
+{
+    const SafeAny::TypeTag tag = SafeAny::getTypeTag( value );
+    const bool is_string = (tag == SafeAny::TypeTag::STRING);
+
+    uint64_t bits = 0;
+    std::string str;
+
+    if( is_string ){
+        str = value.extract<std::string>();
+    }
+    else if( SafeAny::isNumber(tag) ){
+        bits = SafeAny::numberToBits(value, tag);
+    }
+    else{
+        throw std::runtime_error("BlackboardShm: only numbers and strings can be stored");
+    }
+
+    uint32_t str_offset = slot.str_offset;
+    uint32_t str_capacity = slot.str_capacity;
+
+    if( is_string && str.size() > str_capacity )
+    {
+        // The pool is a bump allocator: the old buffer is not recycled.
+        const uint32_t used = header_->pool_used.load(std::memory_order_relaxed);
+        if( uint64_t(used) + str.size() > header_->pool_size ){
+            throw std::runtime_error("BlackboardShm: string pool exhausted");
+        }
+        str_offset = used;
+        str_capacity = static_cast<uint32_t>(str.size());
+        header_->pool_used.store( used + str_capacity, std::memory_order_relaxed );
+    }
+
+    // even: a dead writer is repaired by lock()
+    const uint32_t seq = slot.sequence.load(std::memory_order_relaxed) + 1;
+    slot.sequence.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.type = static_cast<uint8_t>(tag);
+    slot.value = bits;
+    if( is_string )
+    {
+        memcpy( pool() + str_offset, str.data(), str.size() );
+        slot.str_offset = str_offset;
+        slot.str_size = static_cast<uint32_t>(str.size());
+        slot.str_capacity = str_capacity;
+    }
+    slot.sequence.store(seq + 1, std::memory_order_release);
+}
+
+
+#endif // BLACKBOARD_SHM_H
@@ -0,0 +1,243 @@
+#ifndef BLACKBOARD_SQLITE_H
+#define BLACKBOARD_SQLITE_H
+
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <sqlite3.h>
+
+#include "blackboard.h"
+#include "SafeAny/type_tag.hpp"
+
+// Persistent backend based on SQLite.
+//
+// Only this header depends on sqlite3; applications that use it must link the
+// library themselves.
+//
+// Designed for throughput:
+//
+// - set() writes into an in-memory cache and marks the key as dirty. The dirty
+//   entries are written by flush() in a single transaction, either explicitly or
+//   automatically every "batch_size" calls of set(). The destructor flushes too.
+// - get() reads from the cache; SQLite is queried only the first time a key is read.
+// - the database uses WAL journaling, the statements are prepared once and values
+//   are stored as BLOBs using SafeAny::encodeValue().
+//
+// Only numbers and strings can be stored.
+class BlackboardSqlite: public BlackboardImpl
+{
+public:
+
+    BlackboardSqlite(const std::string& filename, std::size_t batch_size = 1024);
+
+    virtual ~BlackboardSqlite() override;
+
+    BlackboardSqlite(const BlackboardSqlite&) = delete;
+    BlackboardSqlite& operator=(const BlackboardSqlite&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override;
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override;
+
+    // Write all the pending changes to the database.
+    void flush();
+
+    std::size_t pendingChanges() const { return dirty_.size(); }
+
+private:
+
+    struct CacheEntry
+    {
+        SafeAny::Any value;
+        bool dirty;
+    };
+
+    typedef std::unordered_map<std::string, CacheEntry> Cache;
+
+    sqlite3_stmt* prepare(const char* sql);
+
+    void step(sqlite3_stmt* stmt);
+
+    void throwError(const std::string& what) const
+    {
+        throw std::runtime_error("BlackboardSqlite: " + what + ": " + sqlite3_errmsg(db_));
+    }
+
+    sqlite3* db_;
+    sqlite3_stmt* select_;
+    sqlite3_stmt* insert_;
+    sqlite3_stmt* begin_;
+    sqlite3_stmt* commit_;
+    sqlite3_stmt* rollback_;
+
+    std::size_t batch_size_;
+    mutable Cache cache_;
+    // pointers, not iterators: they stay valid when get() rehashes the cache
+    std::vector<Cache::value_type*> dirty_;
+    std::string buffer_;
+};
+
+//----------------------------------------------------------
+
+inline BlackboardSqlite::BlackboardSqlite(const std::string& filename, std::size_t batch_size):
+    db_(nullptr), select_(nullptr), insert_(nullptr),
+    begin_(nullptr), commit_(nullptr), rollback_(nullptr),
+    batch_size_( std::max<std::size_t>(batch_size, 1) )
+{
+    if( sqlite3_open( filename.c_str(), &db_ ) != SQLITE_OK )
+    {
+        const std::string msg = db_ ? sqlite3_errmsg(db_) : "out of memory";
+        sqlite3_close(db_);
+        throw std::runtime_error("BlackboardSqlite: can't open " + filename + ": " + msg);
+    }
+
+    const char* setup =
+            "PRAGMA journal_mode=WAL;"
+            "PRAGMA synchronous=NORMAL;"
+            "CREATE TABLE IF NOT EXISTS blackboard("
+            "  key TEXT PRIMARY KEY NOT NULL,"
+            "  value BLOB NOT NULL) WITHOUT ROWID;";
+
+    try{
+        if( sqlite3_exec( db_, setup, nullptr, nullptr, nullptr ) != SQLITE_OK ){
+            throwError("can't create the table");
+        }
+        select_   = prepare("SELECT value FROM blackboard WHERE key = ?1;");
+        insert_   = prepare("INSERT OR REPLACE INTO blackboard(key, value) VALUES(?1, ?2);");
+        begin_    = prepare("BEGIN;");
+        commit_   = prepare("COMMIT;");
+        rollback_ = prepare("ROLLBACK;");
+    }
+    catch(...)
+    {
+        for(sqlite3_stmt* stmt: {select_, insert_, begin_, commit_, rollback_}){
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db_);
+        throw;
+    }
+}
+
+inline BlackboardSqlite::~BlackboardSqlite()
+{
+    try{
+        flush();
+    }
+    catch(std::exception& err)
+    {
+        std::cerr << err.what() << std::endl;
+    }
+    for(sqlite3_stmt* stmt: {select_, insert_, begin_, commit_, rollback_}){
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db_);
+}
+
+inline sqlite3_stmt* BlackboardSqlite::prepare(const char* sql)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if( sqlite3_prepare_v2( db_, sql, -1, &stmt, nullptr ) != SQLITE_OK ){
+        throwError( std::string("can't prepare \"") + sql + "\"");
+    }
+    return stmt;
+}
+
+inline void BlackboardSqlite::step(sqlite3_stmt* stmt)
+{
+    const int res = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if( res != SQLITE_DONE ){
+        throwError("can't execute the statement");
+    }
+}
+
+inline const SafeAny::Any* BlackboardSqlite::get(const std::string& key) const
+{
+    auto it = cache_.find(key);
+    if( it != cache_.end() ){
+        return &(it->second.value);
+    }
+
+    sqlite3_bind_text( select_, 1, key.data(), static_cast<int>(key.size()), SQLITE_STATIC );
+
+    const SafeAny::Any* result = nullptr;
+    if( sqlite3_step( select_ ) == SQLITE_ROW )
+    {
+        const char* blob = static_cast<const char*>( sqlite3_column_blob(select_, 0) );
+        const char* end = blob + sqlite3_column_bytes(select_, 0);
+
+        SafeAny::Any value;
+        if( blob && SafeAny::decodeValue(blob, end, value) )
+        {
+            CacheEntry& entry = cache_[key];
+            entry.value = std::move(value);
+            entry.dirty = false;
+            result = &entry.value;
+        }
+    }
+    sqlite3_reset( select_ );
+    sqlite3_clear_bindings( select_ );
+    return result;
+}
+
+inline void BlackboardSqlite::set(const std::string& key, const SafeAny::Any& value)
+{
+    const SafeAny::TypeTag tag = SafeAny::getTypeTag( value );
+    if( !SafeAny::isNumber(tag) && tag != SafeAny::TypeTag::STRING ){
+        throw std::runtime_error("BlackboardSqlite: only numbers and strings can be stored");
+    }
+
+    auto it = cache_.find(key);
+    if( it == cache_.end() ){
+        it = cache_.insert( {key, CacheEntry{ value, false } } ).first;
+    }
+    else{
+        it->second.value = value;
+    }
+    if( !it->second.dirty )
+    {
+        it->second.dirty = true;
+        dirty_.push_back( &(*it) );
+    }
+
+    if( dirty_.size() >= batch_size_ ){
+        flush();
+    }
+}
+
+inline void BlackboardSqlite::flush()
+{
+    if( dirty_.empty() ) { return; }
+
+    step( begin_ );
+    try{
+        for(const auto* it: dirty_)
+        {
+            buffer_.clear();
+            SafeAny::encodeValue( it->second.value, buffer_ );
+
+            sqlite3_bind_text( insert_, 1, it->first.data(),
+                               static_cast<int>(it->first.size()), SQLITE_STATIC );
+            sqlite3_bind_blob( insert_, 2, buffer_.data(),
+                               static_cast<int>(buffer_.size()), SQLITE_STATIC );
+            step( insert_ );
+        }
+        sqlite3_clear_bindings( insert_ );
+        step( commit_ );
+    }
+    catch(...)
+    {
+        sqlite3_clear_bindings( insert_ );
+        sqlite3_step( rollback_ );
+        sqlite3_reset( rollback_ );
+        throw;
+    }
+
+    for(auto* it: dirty_){
+        it->second.dirty = false;
+    }
+    dirty_.clear();
+}
+
+
+#endif // BLACKBOARD_SQLITE_H
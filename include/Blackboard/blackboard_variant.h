@@ -0,0 +1,160 @@
+#ifndef BLACKBOARD_VARIANT_H
+#define BLACKBOARD_VARIANT_H
+
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+#include "blackboard.h"
+#include "SafeAny/variant.hpp"
+
+// Key/value storage for a closed set of types, known at compile time:
+//
+//    struct Pose { double x, y, theta; };
+//    BlackboardVariant<double, int32_t, std::string, Pose> bb;
+//
+//    bb.set("pose", Pose{1, 2, 0});
+//    bb.set("speed", int32_t(3));
+//    double speed;
+//    bb.get("speed", speed);        // converted with the rules of SafeAny::Any
+//
+// The values are SafeAny::Variant, stored inline in the nodes of the map: updating
+// a key doesn't allocate (a string that doesn't grow is assigned in place), and
+// set(), get() and tryGet() are templates without virtual calls nor type erasure,
+// that the compiler inlines into the caller.
+//
+// It is also a BlackboardImpl, to be used by the Blackboard front-end: in that
+// case the values are copied into a SafeAny::Any the first time they are read
+// after a change, and the values set must have one of the types of the variant
+// (std::runtime_error otherwise).
+template <typename... Types>
+class BlackboardVariant: public BlackboardImpl
+{
+public:
+
+    typedef SafeAny::Variant<Types...> Value;
+
+    BlackboardVariant() = default;
+
+    BlackboardVariant(const BlackboardVariant&) = delete;
+    BlackboardVariant& operator=(const BlackboardVariant&) = delete;
+
+    template <typename T, typename U = typename std::decay<T>::type>
+    typename std::enable_if< Value::template has_alternative<U>::value >::type
+    set(const std::string& key, T&& value)
+    {
+        auto it = storage_.find(key);
+        if( it == storage_.end() )
+        {
+            storage_.emplace( key, Entry( Value( std::forward<T>(value) ) ) );
+            return;
+        }
+        it->second.value.set( std::forward<T>(value) );
+        it->second.any_valid = false;
+    }
+
+    void set(const std::string& key, const char* value)
+    {
+        set( key, std::string(value) );
+    }
+
+    // Same as BlackboardFrontEnd::tryGet().
+    template <typename T> SafeAny::ConversionError tryGet(const std::string& key, T& value) const
+    {
+        auto it = storage_.find(key);
+        if( it == storage_.end() ){ return SafeAny::ConversionError::MissingKey; }
+        return it->second.value.tryConvert(value);
+    }
+
+    // Same as BlackboardFrontEnd::get(): false if the key is missing, throws if the conversion fails.
+    template <typename T> bool get(const std::string& key, T& value) const
+    {
+        const SafeAny::ConversionError error = tryGet(key, value);
+        if( error == SafeAny::ConversionError::MissingKey ){ return false; }
+        if( error != SafeAny::ConversionError::Ok ){ SafeAny::details::throwConversionError(error); }
+        return true;
+    }
+
+    // Pointer to the stored value if its type is exactly T, nullptr otherwise.
+    template <typename T> const T* getPtr(const std::string& key) const
+    {
+        auto it = storage_.find(key);
+        return it == storage_.end() ? nullptr : it->second.value.template get<T>();
+    }
+
+    const Value* getVariant(const std::string& key) const
+    {
+        auto it = storage_.find(key);
+        return it == storage_.end() ? nullptr : &(it->second.value);
+    }
+
+    std::size_t size() const { return storage_.size(); }
+
+    void reserve(std::size_t count) { storage_.reserve(count); }
+
+    //---------------- BlackboardImpl ----------------
+
+    using BlackboardImpl::set;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override
+    {
+        auto it = storage_.find(key);
+        if( it == storage_.end() ){ return nullptr; }
+        const Entry& entry = it->second;
+        if( !entry.any_valid )
+        {
+            entry.value.toAny( entry.any );
+            entry.any_valid = true;
+        }
+        return &entry.any;
+    }
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override
+    {
+        auto it = storage_.find(key);
+        if( it != storage_.end() )
+        {
+            if( !it->second.value.assign(value) ) { throwWrongType(key); }
+            it->second.any_valid = false;
+            return;
+        }
+        Value variant;
+        if( !variant.assign(value) ) { throwWrongType(key); }
+        storage_.emplace( key, Entry( std::move(variant) ) );
+    }
+
+private:
+
+    struct Entry
+    {
+        explicit Entry(Value&& val): value( std::move(val) ), any_valid(false) {}
+
+        Value value;
+        // copy of the value for BlackboardImpl::get(), made only when needed
+        mutable SafeAny::Any any;
+        mutable bool any_valid;
+    };
+
+    // same hash of BlackboardLocal
+    struct KeyHash
+    {
+        std::size_t operator()(const std::string& key) const
+        {
+            // FNV-1a
+            uint64_t hash = 14695981039346656037ULL;
+            for(char c: key) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    [[noreturn]] static void throwWrongType(const std::string& key)
+    {
+        throw std::runtime_error("BlackboardVariant: the type of [" + key + "] is not one of the alternatives");
+    }
+
+    std::unordered_map<std::string, Entry, KeyHash> storage_;
+};
+
+
+#endif // BLACKBOARD_VARIANT_H
@@ -0,0 +1,502 @@
+#ifndef BLACKBOARD_WAL_H
+#define BLACKBOARD_WAL_H
+
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <thread>
+#include <stdexcept>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "blackboard.h"
+#include "SafeAny/type_tag.hpp"
+
+// Crash-safe backend: an in-memory map plus an append-only log of the set() operations.
+//
+// - Concurrent calls of set() are group-committed: the first caller that finds
+//   the log idle becomes the leader and writes the records of all the waiting
+//   callers with a single write() + fdatasync().
+// - When the log grows over max_log_size, the map is written into a snapshot
+//   and the log is truncated.
+// - At startup the snapshot is mmap-ed and parsed, then only the tail of the log
+//   is replayed. A torn record at the end of the log (crash during a write) is discarded.
+//
+// Files: "<filename>.snapshot" and "<filename>.log".
+// Only numbers and strings can be stored.
+//
+// The pointer returned by get() refers to a copy owned by this blackboard and by
+// the calling thread, valid until the next call of get() on this blackboard from
+// the same thread.
+class BlackboardWal: public BlackboardImpl
+{
+public:
+
+    // If sync_on_set is false, set() returns without waiting for the disk and the
+    // records are written in chunks; call sync() to make them durable.
+    BlackboardWal(const std::string& filename,
+                  bool sync_on_set = true,
+                  std::size_t max_log_size = 64*1024*1024);
+
+    virtual ~BlackboardWal() override;
+
+    BlackboardWal(const BlackboardWal&) = delete;
+    BlackboardWal& operator=(const BlackboardWal&) = delete;
+
+    virtual const SafeAny::Any* get(const std::string& key) const override;
+
+    virtual void set(const std::string& key, const SafeAny::Any& value) override;
+
+    // Wait until all the previous set() are on disk.
+    void sync();
+
+    // Write a snapshot and truncate the log.
+    void compact();
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return storage_.size();
+    }
+
+    std::size_t logSize() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return log_size_;
+    }
+
+    typedef std::unordered_map<std::string, SafeAny::Any> Storage;
+
+    // Format of the records in the log and in the snapshot:
+    // record: [uint32 payload size][uint32 checksum][payload]
+    // payload: [varint key size][key][SafeAny::encodeValue()]
+    static void appendRecord(const std::string& key, const SafeAny::Any& value, std::string& out);
+
+    // Load "<filename>.snapshot" and replay "<filename>.log" into storage.
+    // Returns the file descriptor of the log, opened in append mode, after
+    // discarding any torn record at its end; log_size receives its size.
+    static int recover(const std::string& filename, Storage& storage, std::size_t& log_size);
+
+private:
+
+    static const std::size_t ASYNC_CHUNK_SIZE = 1024*1024;
+
+    static uint32_t checksum(const char* data, std::size_t size)
+    {
+        uint32_t h = 2166136261u; // FNV-1a
+        for (std::size_t i=0; i<size; i++) {
+            h = (h ^ static_cast<uint8_t>(data[i])) * 16777619u;
+        }
+        return h;
+    }
+
+    // Parse the records in [ptr,end), returns the position after the last valid one.
+    static const char* replay(const char* ptr, const char* end, Storage& storage);
+
+    static void loadSnapshot(const std::string& filename, Storage& storage);
+
+    // Called with the mutex locked, by the leader of the group commit.
+    void writePending(std::unique_lock<std::mutex>& lock);
+    void compactLocked();
+
+    std::string snapshot_filename_;
+    std::string log_filename_;
+    bool sync_on_set_;
+    std::size_t max_log_size_;
+    int log_fd_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    Storage storage_;
+
+    std::string pending_;       // records not written yet
+    uint64_t appended_seq_;     // number of records appended to pending_
+    uint64_t durable_seq_;      // number of records on disk
+    bool writing_;
+    std::string error_;
+    std::size_t log_size_;
+
+    // copies returned by get(), one per thread
+    mutable std::unordered_map<std::thread::id, SafeAny::Any> get_copies_;
+};
+
+//----------------------------------------------------------
+
+namespace BlackboardWalDetails
+{
+
+static const char SNAPSHOT_MAGIC[8] = {'B','B','S','N','A','P','0','1'};
+
+inline void writeAll(int fd, const char* data, std::size_t size)
+{
+    while( size > 0 )
+    {
+        const ssize_t res = write(fd, data, size);
+        if( res < 0 )
+        {
+            if( errno == EINTR ) { continue; }
+            throw std::runtime_error("BlackboardWal: write failed");
+        }
+        data += res;
+        size -= static_cast<std::size_t>(res);
+    }
+}
+
+// mmap of a whole file, read-only
+struct MappedFile
+{
+    const char* data;
+    std::size_t size;
+
+    MappedFile(int fd): data(nullptr), size(0)
+    {
+        struct stat st;
+        if( fstat(fd, &st) != 0 ){
+            throw std::runtime_error("BlackboardWal: can't stat file");
+        }
+        size = static_cast<std::size_t>(st.st_size);
+        if( size > 0 )
+        {
+            void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if( ptr == MAP_FAILED ){
+                throw std::runtime_error("BlackboardWal: can't map file");
+            }
+            madvise(ptr, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(ptr);
+        }
+    }
+    ~MappedFile()
+    {
+        if( data ) { munmap( const_cast<char*>(data), size ); }
+    }
+};
+
+// fsync of the directory containing "filename", to make a rename() durable
+inline void syncDirectory(const std::string& filename)
+{
+    const std::size_t slash = filename.rfind('/');
+    const std::string directory = slash == std::string::npos ? std::string(".") :
+                                  slash == 0 ? std::string("/") : filename.substr(0, slash);
+    const int fd = open( directory.c_str(), O_RDONLY | O_DIRECTORY );
+    if( fd < 0 ){
+        throw std::runtime_error("BlackboardWal: can't open the directory " + directory);
+    }
+    const int res = fsync(fd);
+    close(fd);
+    if( res != 0 ){
+        throw std::runtime_error("BlackboardWal: fsync failed on the directory " + directory);
+    }
+}
+
+// closes the file descriptor at the end of the scope
+struct FileCloser
+{
+    int fd;
+    ~FileCloser() { close(fd); }
+};
+
+} // end namespace BlackboardWalDetails
+
+
+inline BlackboardWal::BlackboardWal(const std::string& filename,
+                                    bool sync_on_set,
+                                    std::size_t max_log_size):
+    snapshot_filename_( filename + ".snapshot" ),
+    log_filename_( filename + ".log" ),
+    sync_on_set_( sync_on_set ),
+    max_log_size_( max_log_size ),
+    log_fd_( -1 ),
+    appended_seq_(0),
+    durable_seq_(0),
+    writing_(false),
+    log_size_(0)
+{
+    log_fd_ = recover(filename, storage_, log_size_);
+}
+
+inline BlackboardWal::~BlackboardWal()
+{
+    try{
+        sync();
+    }
+    catch(std::exception& err)
+    {
+        std::cerr << err.what() << std::endl;
+    }
+    close(log_fd_);
+}
+
+inline void BlackboardWal::appendRecord(const std::string& key,
+                                        const SafeAny::Any& value,
+                                        std::string& out)
+{
+    const std::size_t header_pos = out.size();
+    out.append( 2*sizeof(uint32_t), '\0' );
+    SafeAny::details::appendVarint( key.size(), out );
+    out.append( key );
+    SafeAny::encodeValue( value, out );
+
+    const char* payload = out.data() + header_pos + 2*sizeof(uint32_t);
+    const uint32_t header[2] = {
+        static_cast<uint32_t>( out.size() - header_pos - 2*sizeof(uint32_t) ),
+        checksum( payload, out.size() - header_pos - 2*sizeof(uint32_t) ) };
+    memcpy( &out[header_pos], header, sizeof(header) );
+}
+
+inline const char* BlackboardWal::replay(const char* ptr, const char* end, Storage& storage)
+{
+    SafeAny::Any value;
+    while( ptr < end )
+    {
+        uint32_t header[2];
+        if( static_cast<std::size_t>(end - ptr) < sizeof(header) ) { break; }
+        memcpy( header, ptr, sizeof(header) );
+
+        const char* payload = ptr + sizeof(header);
+        if( header[0] > static_cast<std::size_t>(end - payload) ||
+            checksum(payload, header[0]) != header[1] )
+        {
+            break;
+        }
+        const char* payload_end = payload + header[0];
+
+        std::size_t key_size = 0;
+        const char* p = payload;
+        if( !SafeAny::details::readVarint(p, payload_end, key_size) ||
+            key_size > static_cast<std::size_t>(payload_end - p) )
+        {
+            break;
+        }
+        const char* key = p;
+        p += key_size;
+        if( !SafeAny::decodeValue(p, payload_end, value) ) { break; }
+
+        auto it = storage.emplace( std::string(key, key_size), SafeAny::Any() ).first;
+        it->second = std::move(value);
+        ptr = payload_end;
+    }
+    return ptr;
+}
+
+inline void BlackboardWal::loadSnapshot(const std::string& filename, Storage& storage)
+{
+    using namespace BlackboardWalDetails;
+
+    const int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 ) { return; }
+    const FileCloser closer = { fd };
+
+    MappedFile file(fd);
+
+    const std::size_t header_size = sizeof(SNAPSHOT_MAGIC) + sizeof(uint64_t);
+    if( file.size < header_size || memcmp(file.data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ){
+        throw std::runtime_error("BlackboardWal: invalid snapshot " + filename);
+    }
+    uint64_t count;
+    memcpy( &count, file.data + sizeof(SNAPSHOT_MAGIC), sizeof(count) );
+    storage.reserve( static_cast<std::size_t>(count) );
+
+    // the snapshot is renamed only once complete: it must be valid up to its end
+    if( replay( file.data + header_size, file.data + file.size, storage ) != file.data + file.size ){
+        throw std::runtime_error("BlackboardWal: corrupted snapshot " + filename);
+    }
+}
+
+inline int BlackboardWal::recover(const std::string& filename, Storage& storage, std::size_t& log_size)
+{
+    loadSnapshot( filename + ".snapshot", storage );
+
+    const std::string log_filename = filename + ".log";
+    const int fd = open( log_filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644 );
+    if( fd < 0 ){
+        throw std::runtime_error("BlackboardWal: can't open " + log_filename);
+    }
+
+    std::size_t valid_size = 0;
+    std::size_t file_size = 0;
+    try{
+        BlackboardWalDetails::MappedFile file(fd);
+        file_size = file.size;
+        if( file.data ){
+            valid_size = static_cast<std::size_t>( replay( file.data, file.data + file.size, storage ) - file.data );
+        }
+    }
+    catch(...)
+    {
+        close(fd);
+        throw;
+    }
+
+    // discard a torn record written during a crash
+    if( valid_size != file_size && ftruncate( fd, static_cast<off_t>(valid_size) ) != 0 )
+    {
+        close(fd);
+        throw std::runtime_error("BlackboardWal: can't truncate " + log_filename);
+    }
+    log_size = valid_size;
+    return fd;
+}
+
+inline const SafeAny::Any* BlackboardWal::get(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = storage_.find(key);
+    if( it == storage_.end() ){ return nullptr; }
+    SafeAny::Any& copy = get_copies_[ std::this_thread::get_id() ];
+    copy = it->second;
+    return &copy;
+}
+
+inline void BlackboardWal::set(const std::string& key, const SafeAny::Any& value)
+{
+    // encode outside the critical section
+    std::string record;
+    appendRecord(key, value, record);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    storage_[key] = value;
+    pending_.append( record );
+    const uint64_t my_seq = ++appended_seq_;
+
+    if( !sync_on_set_ )
+    {
+        if( pending_.size() >= ASYNC_CHUNK_SIZE && !writing_ ){
+            writePending(lock);
+        }
+        return;
+    }
+
+    while( durable_seq_ < my_seq && error_.empty() )
+    {
+        if( !writing_ ){
+            writePending(lock);
+        }
+        else{
+            cv_.wait(lock);
+        }
+    }
+    if( !error_.empty() ){
+        throw std::runtime_error(error_);
+    }
+}
+
+inline void BlackboardWal::sync()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t target_seq = appended_seq_;
+
+    while( durable_seq_ < target_seq && error_.empty() )
+    {
+        if( !writing_ ){
+            writePending(lock);
+        }
+        else{
+            cv_.wait(lock);
+        }
+    }
+    if( !error_.empty() ){
+        throw std::runtime_error(error_);
+    }
+}
+
+inline void BlackboardWal::writePending(std::unique_lock<std::mutex>& lock)
+{
+    writing_ = true;
+    std::string batch;
+    batch.swap( pending_ );
+    const uint64_t batch_seq = appended_seq_;
+
+    lock.unlock();
+    std::string error;
+    try{
+        BlackboardWalDetails::writeAll( log_fd_, batch.data(), batch.size() );
+        if( fdatasync(log_fd_) != 0 ){
+            error = "BlackboardWal: fdatasync failed";
+        }
+    }
+    catch(std::exception& err)
+    {
+        error = err.what();
+    }
+    lock.lock();
+
+    writing_ = false;
+    if( error.empty() )
+    {
+        log_size_ += batch.size();
+        durable_seq_ = batch_seq;
+        if( log_size_ > max_log_size_ )
+        {
+            try{
+                compactLocked();
+            }
+            catch(std::exception& err)
+            {
+                error = err.what();
+            }
+        }
+    }
+    if( !error.empty() ){
+        // the log can't be trusted any more: every following set() will fail
+        error_ = error;
+    }
+    cv_.notify_all();
+}
+
+inline void BlackboardWal::compact()
+{
+    sync();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while( writing_ ) { cv_.wait(lock); }
+    compactLocked();
+}
+
+inline void BlackboardWal::compactLocked()
+{
+    using namespace BlackboardWalDetails;
+
+    std::string buffer( SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) );
+    const uint64_t count = storage_.size();
+    buffer.append( reinterpret_cast<const char*>(&count), sizeof(count) );
+    for(const auto& it: storage_)
+    {
+        appendRecord( it.first, it.second, buffer );
+    }
+
+    const std::string tmp_filename = snapshot_filename_ + ".tmp";
+    const int fd = open( tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 ){
+        throw std::runtime_error("BlackboardWal: can't create " + tmp_filename);
+    }
+    try{
+        writeAll( fd, buffer.data(), buffer.size() );
+        if( fsync(fd) != 0 ){
+            throw std::runtime_error("BlackboardWal: fsync failed on " + tmp_filename);
+        }
+    }
+    catch(...)
+    {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    if( std::rename( tmp_filename.c_str(), snapshot_filename_.c_str() ) != 0 ){
+        throw std::runtime_error("BlackboardWal: can't rename " + tmp_filename);
+    }
+    // the new snapshot must be durable before the log is emptied
+    syncDirectory( snapshot_filename_ );
+
+    // The snapshot contains everything in the log; if we crash before the truncation,
+    // the log is replayed on top of the snapshot, which is harmless.
+    if( ftruncate( log_fd_, 0 ) != 0 || fdatasync(log_fd_) != 0 ){
+        throw std::runtime_error("BlackboardWal: can't truncate " + log_filename_);
+    }
+    log_size_ = 0;
+}
+
+
+#endif // BLACKBOARD_WAL_H
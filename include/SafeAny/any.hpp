@@ -19,10 +19,178 @@
 #include <typeinfo>
 #include <type_traits>
 #include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <cstdlib>
+#include "memory_resource.hpp"
+
+// Also usable with -fno-exceptions: the errors that would throw call std::abort().
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define LINB_ANY_THROW(exception) throw exception
+#define LINB_ANY_TRY              try
+#define LINB_ANY_CATCH_ALL        catch(...)
+#define LINB_ANY_RETHROW          throw
+#else
+#define LINB_ANY_THROW(exception) std::abort()
+#define LINB_ANY_TRY              if(true)
+#define LINB_ANY_CATCH_ALL        else
+#define LINB_ANY_RETHROW          (void)0
+#endif
 
 namespace linb
 {
 
+/// Thrown when an any containing a move-only type is copied.
+class bad_any_copy : public std::runtime_error
+{
+public:
+    bad_any_copy() : std::runtime_error("the value stored in linb::any can not be copied") {}
+};
+
+namespace detail
+{
+    /// Process-wide table that interns each type once, by its mangled name,
+    /// and assigns it a small integer id. Comparing ids is cheaper than comparing
+    /// std::type_info, which requires a string comparison when the types differ.
+    ///
+    /// The arithmetic types have fixed ids, identical in every registry.
+    /// The other ids are meaningful only within the same registry: a shared library
+    /// built with hidden visibility might end up with its own copy of the
+    /// registry, in that case the comparison falls back to std::type_info.
+    class type_registry
+    {
+    public:
+        enum builtin_id : uint32_t
+        {
+            id_void = 0, id_bool, id_char,
+            id_int8, id_int16, id_int32, id_int64,
+            id_uint8, id_uint16, id_uint32, id_uint64,
+            id_float, id_double,
+            first_user_id
+        };
+
+        type_registry()
+        {
+            const std::type_info* builtins[] = {
+                &typeid(void), &typeid(bool), &typeid(char),
+                &typeid(int8_t), &typeid(int16_t), &typeid(int32_t), &typeid(int64_t),
+                &typeid(uint8_t), &typeid(uint16_t), &typeid(uint32_t), &typeid(uint64_t),
+                &typeid(float), &typeid(double) };
+            for(const std::type_info* type: builtins) {
+                intern_locked(*type);
+            }
+        }
+
+        uint32_t intern(const std::type_info& type)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return intern_locked(type);
+        }
+
+    private:
+        // Types local to different translation units (e.g. in an anonymous namespace)
+        // can have the same name: the types with a given name are told apart by
+        // std::type_info, which compares the local ones by address.
+        uint32_t intern_locked(const std::type_info& type)
+        {
+            std::vector<std::pair<const std::type_info*, uint32_t>>& same_name = ids_[type.name()];
+            for(const auto& entry: same_name) {
+                if( *entry.first == type ) { return entry.second; }
+            }
+            same_name.push_back( {&type, count_} );
+            return count_++;
+        }
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::vector<std::pair<const std::type_info*, uint32_t>>> ids_;
+        uint32_t count_ = 0;
+    };
+
+    /// Exported explicitly, so that the dynamic linker can merge the copies of the
+    /// different shared libraries (GCC emits it as a unique symbol).
+    __attribute__((visibility("default"))) inline type_registry& global_type_registry()
+    {
+        static type_registry registry;
+        return registry;
+    }
+
+    template<typename T>
+    inline uint32_t type_id()
+    {
+        static const uint32_t id = global_type_registry().intern( typeid(T) );
+        return id;
+    }
+
+    /// Types which can allocate their own buffers from a memory_resource provide
+    /// the constructor T(std::allocator_arg_t, memory_resource*, const T&).
+    template<typename T>
+    struct uses_memory_resource :
+        std::is_constructible<T, std::allocator_arg_t, memory_resource*, const T&>
+    {};
+
+    template<typename T>
+    inline void copy_construct(void* where, const T& src, memory_resource* resource, std::true_type)
+    {
+        new (where) T(std::allocator_arg, resource, src);
+    }
+
+    template<typename T>
+    inline void copy_construct(void* where, const T& src, memory_resource*, std::false_type)
+    {
+        new (where) T(src);
+    }
+
+    template<typename T>
+    inline void copy_construct_if_copyable(void* where, const T& src, memory_resource* resource, std::true_type)
+    {
+        copy_construct(where, src, resource, uses_memory_resource<T>());
+    }
+
+    template<typename T>
+    inline void copy_construct_if_copyable(void*, const T&, memory_resource*, std::false_type)
+    {
+        LINB_ANY_THROW(bad_any_copy());
+    }
+
+    /// Copy of src, using the resource also for its buffers when T supports it.
+    /// Throws bad_any_copy if T is move-only.
+    template<typename T>
+    inline void copy_construct(void* where, const T& src, memory_resource* resource)
+    {
+        copy_construct_if_copyable(where, src, resource, std::is_copy_constructible<T>());
+    }
+
+    template<typename T>
+    inline void copy_assign(const void* src, void* dest)
+    {
+        *static_cast<T*>(dest) = *static_cast<const T*>(src);
+    }
+
+    /// copy_assign<T>, or nullptr if T is not copy-assignable.
+    template<typename T>
+    inline void (*copy_assign_function(std::true_type))(const void*, void*)
+    {
+        return &copy_assign<T>;
+    }
+
+    template<typename T>
+    inline void (*copy_assign_function(std::false_type))(const void*, void*)
+    {
+        return nullptr;
+    }
+}
+
+/// Tag of the constructor that stores the value in a shared block, see any::is_shared().
+struct shared_payload_t {};
+static constexpr shared_payload_t shared_payload{};
+
 class bad_any_cast : public std::bad_cast
 {
 public:
@@ -47,7 +215,18 @@ public:
     {
         if(!rhs.empty())
         {
-            rhs.vtable->copy(rhs.storage, this->storage);
+            rhs.vtable->copy(rhs.storage, this->storage, nullptr);
+        }
+    }
+
+    /// Copy of rhs whose memory (if any is needed) is allocated from resource.
+    /// nullptr is the default heap.
+    any(std::allocator_arg_t, memory_resource* resource, const any& rhs) :
+        vtable(rhs.vtable)
+    {
+        if(!rhs.empty())
+        {
+            rhs.vtable->copy(rhs.storage, this->storage, resource);
         }
     }
 
@@ -71,16 +250,41 @@ public:
 
     /// Constructs an object of type any that contains an object of type T direct-initialized with std::forward<ValueType>(value).
     ///
-    /// T shall satisfy the CopyConstructible requirements, otherwise the program is ill-formed.
-    /// This is because an `any` may be copy constructed into another `any` at any time, so a copy should always be allowed.
+    /// Unlike N4562, T may be move-only (e.g. std::unique_ptr): copying such an any throws bad_any_copy.
     template<typename ValueType, typename = typename std::enable_if<!std::is_same<typename std::decay<ValueType>::type, any>::value>::type>
     any(ValueType&& value)
     {
-        static_assert(std::is_copy_constructible<typename std::decay<ValueType>::type>::value,
-            "T shall satisfy the CopyConstructible requirements.");
         this->construct(std::forward<ValueType>(value));
     }
 
+    /// Constructs an object of type any that contains a copy of value, allocated from resource
+    /// when it doesn't fit in the small buffer (or when it allocates buffers itself, see
+    /// detail::uses_memory_resource).
+    template<typename ValueType, typename = typename std::enable_if<!std::is_same<typename std::decay<ValueType>::type, any>::value>::type>
+    any(std::allocator_arg_t, memory_resource* resource, const ValueType& value)
+    {
+        static_assert(std::is_copy_constructible<ValueType>::value,
+            "T shall satisfy the CopyConstructible requirements.");
+        this->vtable = vtable_for_type<ValueType>();
+        do_construct_copy<ValueType>(value, resource);
+    }
+
+    /// Constructs an immutable, reference-counted object of type T from value:
+    /// the copies of this any share it, therefore copying is O(1) whatever the size of T.
+    /// The block is allocated from the default heap, also when the any is copied with a
+    /// memory_resource.
+    template<typename ValueType>
+    any(shared_payload_t, ValueType&& value)
+    {
+        using T = typename std::decay<ValueType>::type;
+        using block = typename vtable_shared<T>::block;
+
+        block* ptr = new block(std::forward<ValueType>(value));
+        storage.shared.ptr = &ptr->value;
+        storage.shared.block = ptr;
+        this->vtable = vtable_for_shared_type<T>();
+    }
+
     /// Has the same effect as any(rhs).swap(*this). No effects if an exception is thrown.
     any& operator=(const any& rhs)
     {
@@ -99,18 +303,39 @@ public:
     }
 
     /// Has the same effect as any(std::forward<ValueType>(value)).swap(*this). No effect if a exception is thrown.
-    ///
-    /// T shall satisfy the CopyConstructible requirements, otherwise the program is ill-formed.
-    /// This is because an `any` may be copy constructed into another `any` at any time, so a copy should always be allowed.
     template<typename ValueType, typename = typename std::enable_if<!std::is_same<typename std::decay<ValueType>::type, any>::value>::type>
     any& operator=(ValueType&& value)
     {
-        static_assert(std::is_copy_constructible<typename std::decay<ValueType>::type>::value,
-            "T shall satisfy the CopyConstructible requirements.");
         any(std::forward<ValueType>(value)).swap(*this);
         return *this;
     }
 
+    /// If *this and rhs contain the same type, copy-assigns the contained object of rhs
+    /// to the one of *this, reusing its memory (e.g. the capacity of a std::vector),
+    /// and returns true. Otherwise returns false and does nothing.
+    bool assign_in_place(const any& rhs)
+    {
+        if(this->empty() || this->vtable != rhs.vtable || this->vtable->assign == nullptr)
+            return false;
+        this->vtable->assign(rhs.vtable->dynamic ? rhs.storage.dynamic.ptr : &rhs.storage.stack,
+                             this->vtable->dynamic ? this->storage.dynamic.ptr : &this->storage.stack);
+        return true;
+    }
+
+    /// Destroys the contained object (or releases the shared one) and constructs
+    /// one of type T from args, in place.
+    /// If the previous object was allocated from a memory_resource, so is the new one.
+    /// If an exception is thrown, *this is empty.
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args)
+    {
+        memory_resource* resource = this->resource();
+        this->clear();
+        do_emplace<T>(resource, std::forward<Args>(args)...);
+        this->vtable = vtable_for_type<T>();
+        return *cast<T>();
+    }
+
     /// If not empty, destroys the contained object.
     void clear() noexcept
     {
@@ -133,6 +358,40 @@ public:
         return empty()? typeid(void) : this->vtable->type();
     }
 
+    /// Id of the contained type in the process-wide type registry; detail::type_registry::id_void if empty.
+    /// The ids of the arithmetic types are fixed, see detail::type_registry::builtin_id.
+    uint32_t type_id() const noexcept
+    {
+        return empty()? uint32_t(detail::type_registry::id_void) : this->vtable->id;
+    }
+
+    /// Resource of the dynamically allocated object; nullptr if it lives in the
+    /// small buffer or in the default heap (shared objects included).
+    memory_resource* resource() const noexcept
+    {
+        return (!empty() && this->vtable->dynamic && !this->vtable->shared)? storage.dynamic.resource : nullptr;
+    }
+
+    /// True if the contained object was created with shared_payload: it is immutable,
+    /// the non-const any_cast returns nullptr and assign_in_place returns false.
+    bool is_shared() const noexcept
+    {
+        return !empty() && this->vtable->shared;
+    }
+
+    /// False if *this contains a move-only object: copying it throws bad_any_copy.
+    bool is_copyable() const noexcept
+    {
+        return empty() || this->vtable->copyable;
+    }
+
+    /// Same as *any_cast<T>(this), without checking the type: the contained object must be a T.
+    template<typename T>
+    const T& unchecked_cast() const noexcept
+    {
+        return *cast<T>();
+    }
+
     /// Exchange the states of *this and rhs.
     void swap(any& rhs) noexcept
     {
@@ -169,7 +428,21 @@ private: // Storage and Virtual Method Table
     {
         using stack_storage_t = typename std::aligned_storage<2 * sizeof(void*), std::alignment_of<void*>::value>::type;
 
-        void*               dynamic;
+        struct dynamic_storage
+        {
+            void*            ptr;
+            memory_resource* resource;  // nullptr: default heap
+        };
+
+        /// Same layout of the first word of dynamic_storage: ptr points to the object.
+        struct shared_storage
+        {
+            void*            ptr;
+            void*            block;     // vtable_shared<T>::block
+        };
+
+        dynamic_storage     dynamic;
+        shared_storage      shared;
         stack_storage_t     stack;      // 2 words for e.g. shared_ptr
     };
 
@@ -188,7 +461,8 @@ private: // Storage and Virtual Method Table
 
         /// Copies the **inner** content of the src union into the yet unitialized dest union.
         /// As such, both inner objects will have the same state, but on separate memory locations.
-        void(*copy)(const storage_union& src, storage_union& dest);
+        /// The memory of dest is allocated from resource.
+        void(*copy)(const storage_union& src, storage_union& dest, memory_resource* resource);
 
         /// Moves the storage from src to the yet unitialized dest union.
         /// The state of src after this call is unspecified, caller must ensure not to use src anymore.
@@ -196,6 +470,25 @@ private: // Storage and Virtual Method Table
 
         /// Exchanges the storage between lhs and rhs.
         void(*swap)(storage_union& lhs, storage_union& rhs) noexcept;
+
+        /// Id of the type in the registry below.
+        uint32_t id;
+
+        /// Registry that assigned the id.
+        const detail::type_registry* registry;
+
+        /// True if the object is allocated outside of the union (vtable_dynamic or vtable_shared).
+        bool dynamic;
+
+        /// Copy-assigns the object pointed by src to the one pointed by dest (same type).
+        /// nullptr if the type is not copy-assignable or if the object is shared.
+        void(*assign)(const void* src, void* dest);
+
+        /// True if the object is reference-counted (vtable_shared).
+        bool shared;
+
+        /// False if copy throws bad_any_copy (move-only types).
+        bool copyable;
     };
 
     /// VTable for dynamically allocated storage.
@@ -209,19 +502,29 @@ private: // Storage and Virtual Method Table
 
         static void destroy(storage_union& storage) noexcept
         {
-            //assert(reinterpret_cast<T*>(storage.dynamic));
-            delete reinterpret_cast<T*>(storage.dynamic);
+            //assert(reinterpret_cast<T*>(storage.dynamic.ptr));
+            reinterpret_cast<T*>(storage.dynamic.ptr)->~T();
+            detail::deallocate(storage.dynamic.resource, storage.dynamic.ptr, sizeof(T), alignof(T));
         }
 
-        static void copy(const storage_union& src, storage_union& dest)
+        static void copy(const storage_union& src, storage_union& dest, memory_resource* resource)
         {
-            dest.dynamic = new T(*reinterpret_cast<const T*>(src.dynamic));
+            void* ptr = detail::allocate(resource, sizeof(T), alignof(T));
+            LINB_ANY_TRY {
+                detail::copy_construct(ptr, *reinterpret_cast<const T*>(src.dynamic.ptr), resource);
+            }
+            LINB_ANY_CATCH_ALL {
+                detail::deallocate(resource, ptr, sizeof(T), alignof(T));
+                LINB_ANY_RETHROW;
+            }
+            dest.dynamic.ptr = ptr;
+            dest.dynamic.resource = resource;
         }
 
         static void move(storage_union& src, storage_union& dest) noexcept
         {
             dest.dynamic = src.dynamic;
-            src.dynamic = nullptr;
+            src.dynamic.ptr = nullptr;
         }
 
         static void swap(storage_union& lhs, storage_union& rhs) noexcept
@@ -231,6 +534,49 @@ private: // Storage and Virtual Method Table
         }
     };
 
+    /// VTable for immutable objects shared by all the copies of the any.
+    template<typename T>
+    struct vtable_shared
+    {
+        struct block
+        {
+            template<typename ValueType>
+            explicit block(ValueType&& val) : refs(1), value(std::forward<ValueType>(val)) {}
+
+            std::atomic<std::size_t> refs;
+            T value;
+        };
+
+        static const std::type_info& type() noexcept
+        {
+            return typeid(T);
+        }
+
+        static void destroy(storage_union& storage) noexcept
+        {
+            block* ptr = static_cast<block*>(storage.shared.block);
+            if(ptr->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete ptr;
+        }
+
+        static void copy(const storage_union& src, storage_union& dest, memory_resource*)
+        {
+            static_cast<block*>(src.shared.block)->refs.fetch_add(1, std::memory_order_relaxed);
+            dest.shared = src.shared;
+        }
+
+        static void move(storage_union& src, storage_union& dest) noexcept
+        {
+            dest.shared = src.shared;
+            src.shared.block = nullptr;
+        }
+
+        static void swap(storage_union& lhs, storage_union& rhs) noexcept
+        {
+            std::swap(lhs.shared, rhs.shared);
+        }
+    };
+
     /// VTable for stack allocated storage.
     template<typename T>
     struct vtable_stack
@@ -245,9 +591,9 @@ private: // Storage and Virtual Method Table
             reinterpret_cast<T*>(&storage.stack)->~T();
         }
 
-        static void copy(const storage_union& src, storage_union& dest)
+        static void copy(const storage_union& src, storage_union& dest, memory_resource* resource)
         {
-            new (&dest.stack) T(reinterpret_cast<const T&>(src.stack));
+            detail::copy_construct(&dest.stack, reinterpret_cast<const T&>(src.stack), resource);
         }
 
         static void move(storage_union& src, storage_union& dest) noexcept
@@ -285,6 +631,24 @@ private: // Storage and Virtual Method Table
             VTableType::type, VTableType::destroy,
             VTableType::copy, VTableType::move,
             VTableType::swap,
+            detail::type_id<T>(), &detail::global_type_registry(),
+            requires_allocation<T>::value,
+            detail::copy_assign_function<T>(std::is_copy_assignable<T>()),
+            false, std::is_copy_constructible<T>::value
+        };
+        return &table;
+    }
+
+    /// Returns the pointer to the vtable of the shared objects of type T.
+    template<typename T>
+    static vtable_type* vtable_for_shared_type()
+    {
+        static vtable_type table = {
+            vtable_shared<T>::type, vtable_shared<T>::destroy,
+            vtable_shared<T>::copy, vtable_shared<T>::move,
+            vtable_shared<T>::swap,
+            detail::type_id<T>(), &detail::global_type_registry(),
+            true, nullptr, true, true
         };
         return &table;
     }
@@ -301,27 +665,50 @@ protected:
         return is_same(this->type(), t);
     }
 
+    /// Same result as is_typed(typeid(T)), but compares the ids of the type registry
+    /// when possible. The type_info are compared only when the two ids come from
+    /// different registries (i.e. different shared libraries) and neither is builtin.
+    template<typename T>
+    bool is_typed() const
+    {
+        if( empty() ) return false;
+
+        const uint32_t id = detail::type_id<typename std::remove_cv<T>::type>();
+        if( this->vtable->registry == &detail::global_type_registry()
+            || id < detail::type_registry::first_user_id
+            || this->vtable->id < detail::type_registry::first_user_id )
+        {
+            return this->vtable->id == id;
+        }
+        return is_same(this->vtable->type(), typeid(T));
+    }
+
     /// Checks if two type infos are the same.
     ///
     /// If ANY_IMPL_FAST_TYPE_INFO_COMPARE is defined, checks only the address of the
     /// type infos, otherwise does an actual comparision. Checking addresses is
     /// only a valid approach when there's no interaction with outside sources
     /// (other shared libraries and such).
+    ///
+    /// Without ANY_IMPL_FAST_TYPE_INFO_COMPARE, the addresses are still compared first:
+    /// within the same shared library they are equal and the comparison of the names
+    /// is needed only for types coming from a different one (e.g. blackboard plugins).
     static bool is_same(const std::type_info& a, const std::type_info& b)
     {
 #ifdef ANY_IMPL_FAST_TYPE_INFO_COMPARE
         return &a == &b;
 #else
-        return a == b;
+        return &a == &b || a == b;
 #endif
     }
 
     /// Casts (with no type_info checks) the storage pointer as const T*.
+    /// Also a small T is outside of the union when it is shared.
     template<typename T>
     const T* cast() const noexcept
     {
-        return requires_allocation<typename std::decay<T>::type>::value?
-            reinterpret_cast<const T*>(storage.dynamic) :
+        return (requires_allocation<typename std::decay<T>::type>::value || this->vtable->dynamic)?
+            reinterpret_cast<const T*>(storage.dynamic.ptr) :
             reinterpret_cast<const T*>(&storage.stack);
     }
 
@@ -329,8 +716,8 @@ protected:
     template<typename T>
     T* cast() noexcept
     {
-        return requires_allocation<typename std::decay<T>::type>::value?
-            reinterpret_cast<T*>(storage.dynamic) :
+        return (requires_allocation<typename std::decay<T>::type>::value || this->vtable->dynamic)?
+            reinterpret_cast<T*>(storage.dynamic.ptr) :
             reinterpret_cast<T*>(&storage.stack);
     }
 
@@ -342,7 +729,8 @@ private:
     typename std::enable_if<requires_allocation<T>::value>::type
     do_construct(ValueType&& value)
     {
-        storage.dynamic = new T(std::forward<ValueType>(value));
+        storage.dynamic.ptr = new T(std::forward<ValueType>(value));
+        storage.dynamic.resource = nullptr;
     }
 
     template<typename ValueType, typename T>
@@ -352,6 +740,45 @@ private:
         new (&storage.stack) T(std::forward<ValueType>(value));
     }
 
+    template<typename T>
+    typename std::enable_if<requires_allocation<T>::value>::type
+    do_construct_copy(const T& value, memory_resource* resource)
+    {
+        storage_union src;
+        src.dynamic.ptr = const_cast<T*>(&value);
+        vtable_dynamic<T>::copy(src, storage, resource);
+    }
+
+    template<typename T>
+    typename std::enable_if<!requires_allocation<T>::value>::type
+    do_construct_copy(const T& value, memory_resource* resource)
+    {
+        detail::copy_construct(&storage.stack, value, resource);
+    }
+
+    template<typename T, typename... Args>
+    typename std::enable_if<requires_allocation<T>::value>::type
+    do_emplace(memory_resource* resource, Args&&... args)
+    {
+        void* ptr = detail::allocate(resource, sizeof(T), alignof(T));
+        LINB_ANY_TRY {
+            new (ptr) T(std::forward<Args>(args)...);
+        }
+        LINB_ANY_CATCH_ALL {
+            detail::deallocate(resource, ptr, sizeof(T), alignof(T));
+            LINB_ANY_RETHROW;
+        }
+        storage.dynamic.ptr = ptr;
+        storage.dynamic.resource = resource;
+    }
+
+    template<typename T, typename... Args>
+    typename std::enable_if<!requires_allocation<T>::value>::type
+    do_emplace(memory_resource*, Args&&... args)
+    {
+        new (&storage.stack) T(std::forward<Args>(args)...);
+    }
+
     /// Chooses between stack and dynamic allocation for the type decay_t<ValueType>,
     /// assigns the correct vtable, and constructs the object on our storage.
     template<typename ValueType>
@@ -387,16 +814,40 @@ template<typename ValueType>
 inline ValueType any_cast(const any& operand)
 {
     auto p = any_cast<typename std::add_const<typename std::remove_reference<ValueType>::type>::type>(&operand);
-    if(p == nullptr) throw bad_any_cast();
+    if(p == nullptr) LINB_ANY_THROW(bad_any_cast());
     return *p;
 }
 
+namespace detail
+{
+    /// Only a non-const reference needs the non-const any_cast: a copy can be done
+    /// also from a shared (immutable) object.
+    template<typename ValueType>
+    struct any_cast_needs_mutable :
+        std::integral_constant<bool, std::is_reference<ValueType>::value
+                               && !std::is_const<typename std::remove_reference<ValueType>::type>::value>
+    {};
+
+    template<typename T>
+    inline T* any_cast_pointer(any& operand, std::true_type)
+    {
+        return any_cast<T>(&operand);
+    }
+
+    template<typename T>
+    inline T* any_cast_pointer(any& operand, std::false_type)
+    {
+        return const_cast<T*>(any_cast<T>(static_cast<const any*>(&operand)));
+    }
+}
+
 /// Performs *any_cast<remove_reference_t<ValueType>>(&operand), or throws bad_any_cast on failure.
 template<typename ValueType>
 inline ValueType any_cast(any& operand)
 {
-    auto p = any_cast<typename std::remove_reference<ValueType>::type>(&operand);
-    if(p == nullptr) throw bad_any_cast();
+    auto p = detail::any_cast_pointer<typename std::remove_reference<ValueType>::type>(
+        operand, detail::any_cast_needs_mutable<ValueType>());
+    if(p == nullptr) LINB_ANY_THROW(bad_any_cast());
     return *p;
 }
 
@@ -421,8 +872,9 @@ inline ValueType any_cast(any&& operand)
     using can_move = std::false_type;
 #endif
 
-    auto p = any_cast<typename std::remove_reference<ValueType>::type>(&operand);
-    if(p == nullptr) throw bad_any_cast();
+    auto p = detail::any_cast_pointer<typename std::remove_reference<ValueType>::type>(operand,
+        std::integral_constant<bool, can_move::value || detail::any_cast_needs_mutable<ValueType>::value>());
+    if(p == nullptr) LINB_ANY_THROW(bad_any_cast());
     return detail::any_cast_move_if_true<ValueType>(p, can_move());
 }
 
@@ -431,18 +883,18 @@ inline ValueType any_cast(any&& operand)
 template<typename T>
 inline const T* any_cast(const any* operand) noexcept
 {
-    if(operand == nullptr || !operand->is_typed(typeid(T)))
+    if(operand == nullptr || !operand->template is_typed<T>())
         return nullptr;
     else
         return operand->cast<T>();
 }
 
 /// If operand != nullptr && operand->type() == typeid(ValueType), a pointer to the object
-/// contained by operand, otherwise nullptr.
+/// contained by operand, otherwise nullptr. Also nullptr if the object is shared (immutable).
 template<typename T>
 inline T* any_cast(any* operand) noexcept
 {
-    if(operand == nullptr || !operand->is_typed(typeid(T)))
+    if(operand == nullptr || !operand->template is_typed<T>() || operand->is_shared())
         return nullptr;
     else
         return operand->cast<T>();
@@ -0,0 +1,140 @@
+#ifndef SAFE_ANY_COMPACT_ANY_H
+#define SAFE_ANY_COMPACT_ANY_H
+
+#include "safe_any.hpp"
+
+namespace SafeAny{
+
+// Value in 16 bytes, for containers of millions of (mostly) numbers.
+//
+// A number is stored inline: 8 bytes of payload and its tag, the id of
+// linb::detail::type_registry, as in NumberAny. Any other value is "boxed": the
+// payload points to a SafeAny::Any allocated on the heap, that owns it.
+// The numbers are not NaN-boxed, because int64_t and uint64_t need all the 64 bits.
+//
+// SafeAny::Any takes 32 bytes, linb::any 24 bytes.
+class CompactAny
+{
+public:
+
+    CompactAny(): _bits(0), _tag(EMPTY) {}
+
+    explicit CompactAny(const Any& value): _bits(0), _tag(EMPTY)
+    {
+        assign(value);
+    }
+
+    template <typename T, typename = typename std::enable_if< details::is_tagged_number<T>::value >::type>
+    explicit CompactAny(T value): _bits(0), _tag(EMPTY)
+    {
+        set(value);
+    }
+
+    CompactAny(const CompactAny& other): _bits(other._bits), _tag(other._tag)
+    {
+        if( _tag == BOXED ) { _bits = box( new Any( *other.boxed() ) ); }
+    }
+
+    CompactAny(CompactAny&& other) noexcept: _bits(other._bits), _tag(other._tag)
+    {
+        other._tag = EMPTY;
+    }
+
+    CompactAny& operator=(const CompactAny& other)
+    {
+        if( this != &other )
+        {
+            CompactAny copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    CompactAny& operator=(CompactAny&& other) noexcept
+    {
+        if( this != &other )
+        {
+            release();
+            _bits = other._bits;
+            _tag = other._tag;
+            other._tag = EMPTY;
+        }
+        return *this;
+    }
+
+    ~CompactAny() { release(); }
+
+    template <typename T> void set(T value)
+    {
+        const NumberAny number(value);
+        release();
+        _bits = number.bits();
+        _tag = static_cast<uint8_t>( number.typeId() );
+    }
+
+    // A boxed value of the same type is assigned in place.
+    void assign(const Any& value)
+    {
+        if( const NumberAny* number = value.number() )
+        {
+            release();
+            _bits = number->bits();
+            _tag = static_cast<uint8_t>( number->typeId() );
+            return;
+        }
+        if( _tag == BOXED )
+        {
+            Any* stored = boxed();
+            if( !stored->assignInPlace(value) ) { *stored = value; }
+            return;
+        }
+        _bits = box( new Any(value) );
+        _tag = BOXED;
+    }
+
+    bool isNumber() const { return _tag != EMPTY && _tag != BOXED; }
+
+    bool empty() const { return _tag == EMPTY; }
+
+    // The number, if isNumber().
+    NumberAny number() const { return NumberAny::fromBits( _tag, _bits ); }
+
+    // The value which is not a number, nullptr otherwise.
+    const Any* boxed() const { return _tag == BOXED ? reinterpret_cast<const Any*>( static_cast<uintptr_t>(_bits) ) : nullptr; }
+
+    Any* boxed() { return const_cast<Any*>( static_cast<const CompactAny*>(this)->boxed() ); }
+
+    uint32_t typeId() const { return _tag == BOXED ? boxed()->typeId() : _tag; }
+
+    template <typename T> ConversionError tryConvert(T& dst) const
+    {
+        return _tag == BOXED ? boxed()->tryConvert(dst) : number().tryConvert(dst);
+    }
+
+    // Copy into a SafeAny::Any.
+    void toAny(Any& out) const
+    {
+        if( _tag == BOXED ) { out = *boxed(); }
+        else { out = Any( number() ); }
+    }
+
+private:
+
+    static const uint8_t EMPTY = linb::detail::type_registry::id_void;
+    static const uint8_t BOXED = 0xFF;
+
+    static uint64_t box(Any* value) { return static_cast<uint64_t>( reinterpret_cast<uintptr_t>(value) ); }
+
+    void release()
+    {
+        if( _tag == BOXED ) { delete boxed(); }
+        _tag = EMPTY;
+    }
+
+    uint64_t _bits;
+    uint8_t _tag;
+};
+
+} // end namespace SafeAny
+
+#endif // SAFE_ANY_COMPACT_ANY_H
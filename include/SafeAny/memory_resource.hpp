@@ -0,0 +1,187 @@
+#ifndef LINB_MEMORY_RESOURCE_HPP
+#define LINB_MEMORY_RESOURCE_HPP
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+
+namespace linb
+{
+
+/// Minimal equivalent of std::pmr::memory_resource (C++17) for C++11 compilers.
+///
+/// Wherever a memory_resource* is accepted, nullptr means the default heap
+/// (operator new / operator delete).
+class memory_resource
+{
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void* ptr, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        do_deallocate(ptr, bytes, alignment);
+    }
+
+protected:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) = 0;
+};
+
+namespace detail
+{
+    inline void* allocate(memory_resource* resource, std::size_t bytes, std::size_t alignment)
+    {
+        return resource ? resource->allocate(bytes, alignment) : ::operator new(bytes);
+    }
+
+    inline void deallocate(memory_resource* resource, void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if(resource) resource->deallocate(ptr, bytes, alignment);
+        else ::operator delete(ptr);
+    }
+}
+
+/// Monotonic arena: memory is carved out of large chunks and deallocate() does
+/// nothing. Everything is returned to the heap at once by release() or by the
+/// destructor, therefore the objects allocated in the arena must be destroyed
+/// (or abandoned, if trivially destructible) before that.
+///
+/// Not thread-safe.
+class arena_resource : public memory_resource
+{
+public:
+    explicit arena_resource(std::size_t chunk_size = 64 * 1024) :
+        chunk_size_(std::max<std::size_t>(chunk_size, 256)),
+        chunks_(nullptr), current_(nullptr), end_(nullptr),
+        bytes_allocated_(0), chunk_count_(0)
+    {
+    }
+
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+
+    ~arena_resource() override
+    {
+        release();
+    }
+
+    /// Frees all the chunks.
+    void release() noexcept
+    {
+        while(chunks_)
+        {
+            chunk_header* next = chunks_->next;
+            ::operator delete(chunks_);
+            chunks_ = next;
+        }
+        current_ = end_ = nullptr;
+        bytes_allocated_ = 0;
+        chunk_count_ = 0;
+    }
+
+    /// Bytes requested by the users of the arena (padding excluded).
+    std::size_t bytes_allocated() const { return bytes_allocated_; }
+
+    std::size_t chunk_count() const { return chunk_count_; }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        char* ptr = align(current_, alignment);
+        if(!current_ || ptr + bytes > end_)
+        {
+            add_chunk(bytes + alignment);
+            ptr = align(current_, alignment);
+        }
+        current_ = ptr + bytes;
+        bytes_allocated_ += bytes;
+        return ptr;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override
+    {
+    }
+
+private:
+    struct chunk_header
+    {
+        chunk_header* next;
+        std::size_t size;
+    };
+
+    static char* align(char* ptr, std::size_t alignment)
+    {
+        const std::uintptr_t value = reinterpret_cast<std::uintptr_t>(ptr);
+        return reinterpret_cast<char*>((value + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+    }
+
+    void add_chunk(std::size_t min_size)
+    {
+        const std::size_t size = std::max(chunk_size_, min_size) + sizeof(chunk_header);
+        chunk_header* chunk = static_cast<chunk_header*>(::operator new(size));
+        chunk->next = chunks_;
+        chunk->size = size;
+        chunks_ = chunk;
+        current_ = reinterpret_cast<char*>(chunk + 1);
+        end_ = reinterpret_cast<char*>(chunk) + size;
+        chunk_count_++;
+    }
+
+    std::size_t   chunk_size_;
+    chunk_header* chunks_;
+    char*         current_;
+    char*         end_;
+    std::size_t   bytes_allocated_;
+    std::size_t   chunk_count_;
+};
+
+/// Allocator for the standard containers, based on a memory_resource
+/// (similar to std::pmr::polymorphic_allocator).
+template<typename T>
+class resource_allocator
+{
+public:
+    typedef T value_type;
+
+    resource_allocator(memory_resource* resource = nullptr) noexcept : resource_(resource) {}
+
+    template<typename U>
+    resource_allocator(const resource_allocator<U>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(detail::allocate(resource_, n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        detail::deallocate(resource_, ptr, n * sizeof(T), alignof(T));
+    }
+
+    memory_resource* resource() const noexcept { return resource_; }
+
+private:
+    memory_resource* resource_;
+};
+
+template<typename T, typename U>
+inline bool operator==(const resource_allocator<T>& a, const resource_allocator<U>& b) noexcept
+{
+    return a.resource() == b.resource();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const resource_allocator<T>& a, const resource_allocator<U>& b) noexcept
+{
+    return a.resource() != b.resource();
+}
+
+}
+
+#endif
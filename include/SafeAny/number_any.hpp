@@ -0,0 +1,165 @@
+#ifndef SAFE_ANY_NUMBER_ANY_H
+#define SAFE_ANY_NUMBER_ANY_H
+
+#include <cstdint>
+#include <cstring>
+#include <typeinfo>
+#include <type_traits>
+#include "any.hpp"
+
+namespace SafeAny{
+
+enum class ConversionError : uint8_t;
+
+namespace details{
+
+// Tag of the types that NumberAny can store: the id of linb::detail::type_registry,
+// 0 for the other types (e.g. long long, which is not one of the intN_t on LP64).
+template <typename T> struct number_tag : std::integral_constant<uint8_t, 0> {};
+
+#define SAFE_ANY_NUMBER_TAG(TYPE, ID) \
+    template <> struct number_tag<TYPE> : std::integral_constant<uint8_t, linb::detail::type_registry::ID> {};
+
+SAFE_ANY_NUMBER_TAG( bool,     id_bool )
+SAFE_ANY_NUMBER_TAG( char,     id_char )
+SAFE_ANY_NUMBER_TAG( int8_t,   id_int8 )
+SAFE_ANY_NUMBER_TAG( int16_t,  id_int16 )
+SAFE_ANY_NUMBER_TAG( int32_t,  id_int32 )
+SAFE_ANY_NUMBER_TAG( int64_t,  id_int64 )
+SAFE_ANY_NUMBER_TAG( uint8_t,  id_uint8 )
+SAFE_ANY_NUMBER_TAG( uint16_t, id_uint16 )
+SAFE_ANY_NUMBER_TAG( uint32_t, id_uint32 )
+SAFE_ANY_NUMBER_TAG( uint64_t, id_uint64 )
+SAFE_ANY_NUMBER_TAG( float,    id_float )
+SAFE_ANY_NUMBER_TAG( double,   id_double )
+
+#undef SAFE_ANY_NUMBER_TAG
+
+template <typename T>
+struct is_tagged_number : std::integral_constant<bool, number_tag<T>::value != 0> {};
+
+} // end namespace details
+
+// Closed set of the arithmetic types (bool, char, intN_t, uintN_t, float and double)
+// in 16 bytes: a tag and an 8 bytes payload. No vtable, heap or typeid: a copy is a
+// plain copy and a conversion is a switch over the tag.
+// SafeAny::Any stores its numbers in a NumberAny.
+class NumberAny
+{
+public:
+    typedef linb::detail::type_registry TR;
+
+    NumberAny(): _tag(TR::id_void)
+    {
+        _payload.u64 = 0;
+    }
+
+    template <typename T, typename = typename std::enable_if< details::is_tagged_number<T>::value >::type>
+    NumberAny(T value)
+    {
+        set(value);
+    }
+
+    template <typename T> void set(T value)
+    {
+        static_assert( details::is_tagged_number<T>::value, "NumberAny stores only the builtin numbers" );
+        // the whole payload is written at once: a narrower store followed by a
+        // load of the 8 bytes (e.g. when the NumberAny is copied) would stall
+        uint64_t bits = 0;
+        std::memcpy( &bits, &value, sizeof(T) );
+        _payload.u64 = bits;
+        _tag = details::number_tag<T>::value;
+    }
+
+    bool empty() const { return _tag == TR::id_void; }
+
+    // Id of the stored type in linb::detail::type_registry (id_void if empty).
+    uint32_t typeId() const { return _tag; }
+
+    const std::type_info& type() const
+    {
+        switch( _tag )
+        {
+        case TR::id_bool:   return typeid(bool);
+        case TR::id_char:   return typeid(char);
+        case TR::id_int8:   return typeid(int8_t);
+        case TR::id_int16:  return typeid(int16_t);
+        case TR::id_int32:  return typeid(int32_t);
+        case TR::id_int64:  return typeid(int64_t);
+        case TR::id_uint8:  return typeid(uint8_t);
+        case TR::id_uint16: return typeid(uint16_t);
+        case TR::id_uint32: return typeid(uint32_t);
+        case TR::id_uint64: return typeid(uint64_t);
+        case TR::id_float:  return typeid(float);
+        case TR::id_double: return typeid(double);
+        default:            return typeid(void);
+        }
+    }
+
+    // Pointer to the value if its type is exactly T, nullptr otherwise.
+    template <typename T> const T* get() const
+    {
+        return ( _tag == details::number_tag<T>::value && _tag != TR::id_void ) ?
+                    reinterpret_cast<const T*>( &_payload ) : nullptr;
+    }
+
+    template <typename T> T* get()
+    {
+        return const_cast<T*>( static_cast<const NumberAny*>(this)->get<T>() );
+    }
+
+    // T must be the stored type.
+    template <typename T> const T& unchecked() const
+    {
+        return *reinterpret_cast<const T*>( &_payload );
+    }
+
+    // Raw representation, to store the number elsewhere: typeId() and the 8 bytes of the payload.
+    uint64_t bits() const { return _payload.u64; }
+
+    static NumberAny fromBits(uint8_t tag, uint64_t bits)
+    {
+        NumberAny number;
+        number._payload.u64 = bits;
+        number._tag = tag;
+        return number;
+    }
+
+    // Same rules of Any::tryConvert() (defined in safe_any.hpp).
+    template <typename T> ConversionError tryConvert(T& dst) const;
+
+    template <typename T> T convert() const;
+
+private:
+    union Payload
+    {
+        bool     b;
+        char     c;
+        int8_t   i8;
+        int16_t  i16;
+        int32_t  i32;
+        int64_t  i64;
+        uint8_t  u8;
+        uint16_t u16;
+        uint32_t u32;
+        uint64_t u64;
+        float    f;
+        double   d;
+    };
+
+    Payload _payload;
+    uint8_t _tag;
+};
+
+namespace details{
+
+// Types that SafeAny::Any stores in its NumberAny.
+template <typename T>
+struct is_stored_as_number : std::integral_constant<bool,
+        is_tagged_number<T>::value || std::is_same<T, NumberAny>::value> {};
+
+} // end namespace details
+
+} // end namespace SafeAny
+
+#endif // SAFE_ANY_NUMBER_ANY_H
@@ -0,0 +1,582 @@
+#ifndef SAFE_ANY_NUMBER_FORMAT_H
+#define SAFE_ANY_NUMBER_FORMAT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace SafeAny{
+
+// Size of the buffer of formatNumber(), enough for any number.
+static const std::size_t NUMBER_BUFFER_SIZE = 32;
+
+// Writes the decimal representation of "value" into "buffer" (not null-terminated)
+// and returns the end of the text. Independent of the locale and without allocations.
+//
+// Integers are written as std::to_string() does (bool and char as numbers).
+// Floating point numbers use the shortest text that is parsed back (by strtod or
+// strtof) to the same value, with the notation of JavaScript: "0.1", "250",
+// "1.5e-7", "1e+21"; "nan", "inf" and "-inf" for the special values.
+template <typename T>
+char* formatNumber(char* buffer, T value);
+
+namespace details{
+
+//----------------------- Integers ----------------------------------------------
+
+inline char* format_unsigned(char* buffer, uint64_t value)
+{
+    static const char pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // written backwards, two digits at a time
+    char digits[20];
+    char* ptr = digits + 20;
+    while( value >= 100 )
+    {
+        const unsigned index = static_cast<unsigned>( value % 100 ) * 2;
+        value /= 100;
+        ptr -= 2;
+        ptr[0] = pairs[index];
+        ptr[1] = pairs[index + 1];
+    }
+    if( value >= 10 )
+    {
+        ptr -= 2;
+        ptr[0] = pairs[value * 2];
+        ptr[1] = pairs[value * 2 + 1];
+    }
+    else
+    {
+        *--ptr = static_cast<char>( '0' + value );
+    }
+    const std::size_t length = static_cast<std::size_t>( digits + 20 - ptr );
+    std::memcpy( buffer, ptr, length );
+    return buffer + length;
+}
+
+inline char* format_signed(char* buffer, int64_t value)
+{
+    if( value < 0 )
+    {
+        *buffer++ = '-';
+        // no overflow for the minimum of int64_t
+        return format_unsigned( buffer, uint64_t(0) - static_cast<uint64_t>(value) );
+    }
+    return format_unsigned( buffer, static_cast<uint64_t>(value) );
+}
+
+//----------------------- Floating point ----------------------------------------------
+// Grisu2 (F. Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with
+// Integers", 2010): the digits always round-trip and they are the shortest ones
+// for almost every value (in the rare exceptions, one digit more).
+
+// f * 2^e
+struct DiyFp
+{
+    uint64_t f;
+    int e;
+
+    DiyFp(uint64_t f_, int e_): f(f_), e(e_) {}
+
+    // rounded upper 64 bits of the 128 bits product
+    static DiyFp mul(const DiyFp& x, const DiyFp& y)
+    {
+        const uint64_t x_lo = x.f & 0xFFFFFFFFu;
+        const uint64_t x_hi = x.f >> 32;
+        const uint64_t y_lo = y.f & 0xFFFFFFFFu;
+        const uint64_t y_hi = y.f >> 32;
+        const uint64_t p0 = x_lo * y_lo;
+        const uint64_t p1 = x_lo * y_hi;
+        const uint64_t p2 = x_hi * y_lo;
+        const uint64_t p3 = x_hi * y_hi;
+        uint64_t middle = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+        middle += uint64_t(1) << 31;
+        return DiyFp( p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32), x.e + y.e + 64 );
+    }
+
+    // x.f must not be zero
+    static DiyFp normalize(DiyFp x)
+    {
+        const int shift = __builtin_clzll( x.f );
+        return DiyFp( x.f << shift, x.e - shift );
+    }
+};
+
+// c = f * 2^e ~= 10^k
+struct CachedPower
+{
+    uint64_t f;
+    int e;
+    int k;
+};
+
+// 10^k for k = -348, -340, ... 340
+inline const CachedPower& cached_power(int index)
+{
+    static const CachedPower powers[] = {
+        { 0xFA8FD5A0081C0288ULL, -1220, -348 }, { 0xBAAEE17FA23EBF76ULL, -1193, -340 },
+        { 0x8B16FB203055AC76ULL, -1166, -332 }, { 0xCF42894A5DCE35EAULL, -1140, -324 },
+        { 0x9A6BB0AA55653B2DULL, -1113, -316 }, { 0xE61ACF033D1A45DFULL, -1087, -308 },
+        { 0xAB70FE17C79AC6CAULL, -1060, -300 }, { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+        { 0xBE5691EF416BD60CULL, -1007, -284 }, { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+        { 0xD3515C2831559A83ULL,  -954, -268 }, { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+        { 0xEA9C227723EE8BCBULL,  -901, -252 }, { 0xAECC49914078536DULL,  -874, -244 },
+        { 0x823C12795DB6CE57ULL,  -847, -236 }, { 0xC21094364DFB5637ULL,  -821, -228 },
+        { 0x9096EA6F3848984FULL,  -794, -220 }, { 0xD77485CB25823AC7ULL,  -768, -212 },
+        { 0xA086CFCD97BF97F4ULL,  -741, -204 }, { 0xEF340A98172AACE5ULL,  -715, -196 },
+        { 0xB23867FB2A35B28EULL,  -688, -188 }, { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+        { 0xC5DD44271AD3CDBAULL,  -635, -172 }, { 0x936B9FCEBB25C996ULL,  -608, -164 },
+        { 0xDBAC6C247D62A584ULL,  -582, -156 }, { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+        { 0xF3E2F893DEC3F126ULL,  -529, -140 }, { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+        { 0x87625F056C7C4A8BULL,  -475, -124 }, { 0xC9BCFF6034C13053ULL,  -449, -116 },
+        { 0x964E858C91BA2655ULL,  -422, -108 }, { 0xDFF9772470297EBDULL,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 }, { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+        { 0xB94470938FA89BCFULL,  -316,  -76 }, { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+        { 0xCDB02555653131B6ULL,  -263,  -60 }, { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+        { 0xE45C10C42A2B3B06ULL,  -210,  -44 }, { 0xAA242499697392D3ULL,  -183,  -36 },
+        { 0xFD87B5F28300CA0EULL,  -157,  -28 }, { 0xBCE5086492111AEBULL,  -130,  -20 },
+        { 0x8CBCCC096F5088CCULL,  -103,  -12 }, { 0xD1B71758E219652CULL,   -77,   -4 },
+        { 0x9C40000000000000ULL,   -50,    4 }, { 0xE8D4A51000000000ULL,   -24,   12 },
+        { 0xAD78EBC5AC620000ULL,     3,   20 }, { 0x813F3978F8940984ULL,    30,   28 },
+        { 0xC097CE7BC90715B3ULL,    56,   36 }, { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+        { 0xD5D238A4ABE98068ULL,   109,   52 }, { 0x9F4F2726179A2245ULL,   136,   60 },
+        { 0xED63A231D4C4FB27ULL,   162,   68 }, { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+        { 0x83C7088E1AAB65DBULL,   216,   84 }, { 0xC45D1DF942711D9AULL,   242,   92 },
+        { 0x924D692CA61BE758ULL,   269,  100 }, { 0xDA01EE641A708DEAULL,   295,  108 },
+        { 0xA26DA3999AEF774AULL,   322,  116 }, { 0xF209787BB47D6B85ULL,   348,  124 },
+        { 0xB454E4A179DD1877ULL,   375,  132 }, { 0x865B86925B9BC5C2ULL,   402,  140 },
+        { 0xC83553C5C8965D3DULL,   428,  148 }, { 0x952AB45CFA97A0B3ULL,   455,  156 },
+        { 0xDE469FBD99A05FE3ULL,   481,  164 }, { 0xA59BC234DB398C25ULL,   508,  172 },
+        { 0xF6C69A72A3989F5CULL,   534,  180 }, { 0xB7DCBF5354E9BECEULL,   561,  188 },
+        { 0x88FCF317F22241E2ULL,   588,  196 }, { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+        { 0x98165AF37B2153DFULL,   641,  212 }, { 0xE2A0B5DC971F303AULL,   667,  220 },
+        { 0xA8D9D1535CE3B396ULL,   694,  228 }, { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+        { 0xBB764C4CA7A44410ULL,   747,  244 }, { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+        { 0xD01FEF10A657842CULL,   800,  260 }, { 0x9B10A4E5E9913129ULL,   827,  268 },
+        { 0xE7109BFBA19C0C9DULL,   853,  276 }, { 0xAC2820D9623BF429ULL,   880,  284 },
+        { 0x80444B5E7AA7CF85ULL,   907,  292 }, { 0xBF21E44003ACDD2DULL,   933,  300 },
+        { 0x8E679C2F5E44FF8FULL,   960,  308 }, { 0xD433179D9C8CB841ULL,   986,  316 },
+        { 0x9E19DB92B4E31BA9ULL,  1013,  324 }, { 0xEB96BF6EBADF77D9ULL,  1039,  332 },
+        { 0xAF87023B9BF0EE6BULL,  1066,  340 },
+    };
+    return powers[index];
+}
+
+// The cached power that brings the binary exponent e into [-60, -32]:
+// the integral part of the scaled value fits 32 bits.
+inline const CachedPower& cached_power_for_exponent(int e)
+{
+    const int f = -60 - e - 1;
+    // ceil( f * log10(2) )
+    const int k = (f * 78913) / (1 << 18) + static_cast<int>( f > 0 );
+    return cached_power( (348 + k + 7) / 8 );
+}
+
+inline void grisu2_round(char* buffer, int length, uint64_t dist, uint64_t delta,
+                         uint64_t rest, uint64_t ten_k)
+{
+    // move the last digit towards the exact value, as long as it stays within the boundaries
+    while( rest < dist && delta - rest >= ten_k &&
+           ( rest + ten_k < dist || dist - rest > rest + ten_k - dist ) )
+    {
+        buffer[length - 1]--;
+        rest += ten_k;
+    }
+}
+
+// Digits of a number between M_minus and M_plus, as close as possible to w.
+inline void grisu2_digits(char* buffer, int& length, int& exponent,
+                          DiyFp M_minus, DiyFp w, DiyFp M_plus)
+{
+    static const uint32_t powers10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                         10000000, 100000000, 1000000000 };
+    uint64_t delta = M_plus.f - M_minus.f;
+    uint64_t dist  = M_plus.f - w.f;
+
+    const DiyFp one( uint64_t(1) << -M_plus.e, M_plus.e );
+    uint32_t p1 = static_cast<uint32_t>( M_plus.f >> -one.e );
+    uint64_t p2 = M_plus.f & (one.f - 1);
+
+    int n = 1;
+    while( n < 10 && p1 >= powers10[n] ) { n++; }
+
+    // integral part
+    while( n > 0 )
+    {
+        const uint32_t pow10 = powers10[n - 1];
+        buffer[length++] = static_cast<char>( '0' + p1 / pow10 );
+        p1 %= pow10;
+        n--;
+        const uint64_t rest = ( uint64_t(p1) << -one.e ) + p2;
+        if( rest <= delta )
+        {
+            exponent += n;
+            grisu2_round( buffer, length, dist, delta, rest, uint64_t(pow10) << -one.e );
+            return;
+        }
+    }
+    // fractional part
+    int m = 0;
+    for(;;)
+    {
+        p2 *= 10;
+        buffer[length++] = static_cast<char>( '0' + (p2 >> -one.e) );
+        p2 &= one.f - 1;
+        m++;
+        delta *= 10;
+        dist *= 10;
+        if( p2 <= delta ) { break; }
+    }
+    exponent -= m;
+    grisu2_round( buffer, length, dist, delta, p2, one.f );
+}
+
+// value = digits * 10^exponent; value is finite and positive.
+template <typename T>
+inline void grisu2(char* buffer, int& length, int& exponent, T value)
+{
+    static const int precision = std::numeric_limits<T>::digits;
+    static const int bias = std::numeric_limits<T>::max_exponent - 1 + (precision - 1);
+    static const uint64_t hidden_bit = uint64_t(1) << (precision - 1);
+    typedef typename std::conditional< sizeof(T) == 4, uint32_t, uint64_t >::type Bits;
+
+    Bits raw;
+    std::memcpy( &raw, &value, sizeof(T) );
+    const uint64_t bits = raw;
+    const uint64_t E = bits >> (precision - 1);
+    const uint64_t F = bits & (hidden_bit - 1);
+
+    const DiyFp v = ( E == 0 ) ? DiyFp( F, 1 - bias ) : DiyFp( F + hidden_bit, static_cast<int>(E) - bias );
+
+    // the boundaries are halfway to the adjacent values; the lower one is closer
+    // when the significand is a power of two
+    const DiyFp plus = DiyFp::normalize( DiyFp( 2*v.f + 1, v.e - 1 ) );
+    DiyFp minus = ( F == 0 && E > 1 ) ? DiyFp( 4*v.f - 1, v.e - 2 ) : DiyFp( 2*v.f - 1, v.e - 1 );
+    minus = DiyFp( minus.f << (minus.e - plus.e), plus.e );
+
+    const CachedPower& cached = cached_power_for_exponent( plus.e );
+    const DiyFp c( cached.f, cached.e );
+    const DiyFp w       = DiyFp::mul( DiyFp::normalize(v), c );
+    const DiyFp w_minus = DiyFp::mul( minus, c );
+    const DiyFp w_plus  = DiyFp::mul( plus, c );
+
+    length = 0;
+    exponent = -cached.k;
+    // the products are rounded: stay inside the boundaries
+    grisu2_digits( buffer, length, exponent,
+                   DiyFp( w_minus.f + 1, w_minus.e ), w, DiyFp( w_plus.f - 1, w_plus.e ) );
+}
+
+inline char* format_exponent(char* buffer, int exponent)
+{
+    *buffer++ = 'e';
+    *buffer++ = exponent < 0 ? '-' : '+';
+    return format_unsigned( buffer, static_cast<uint64_t>( exponent < 0 ? -exponent : exponent ) );
+}
+
+// Places the decimal point (or the exponent) in buffer[0, length) = digits * 10^exponent.
+inline char* format_decimal(char* buffer, int length, int exponent)
+{
+    // 10^(point-1) <= value < 10^point
+    const int point = length + exponent;
+
+    if( exponent >= 0 && point <= 21 )
+    {
+        // 1234e2 -> 123400
+        std::memset( buffer + length, '0', static_cast<std::size_t>( exponent ) );
+        return buffer + point;
+    }
+    if( point > 0 && point <= 21 )
+    {
+        // 1234e-2 -> 12.34
+        std::memmove( buffer + point + 1, buffer + point, static_cast<std::size_t>( length - point ) );
+        buffer[point] = '.';
+        return buffer + length + 1;
+    }
+    if( point > -6 && point <= 0 )
+    {
+        // 1234e-6 -> 0.001234
+        const int offset = 2 - point;
+        std::memmove( buffer + offset, buffer, static_cast<std::size_t>( length ) );
+        buffer[0] = '0';
+        buffer[1] = '.';
+        std::memset( buffer + 2, '0', static_cast<std::size_t>( offset - 2 ) );
+        return buffer + offset + length;
+    }
+    if( length == 1 )
+    {
+        // 1e30
+        return format_exponent( buffer + 1, point - 1 );
+    }
+    // 1234e30 -> 1.234e+33
+    std::memmove( buffer + 2, buffer + 1, static_cast<std::size_t>( length - 1 ) );
+    buffer[1] = '.';
+    return format_exponent( buffer + length + 1, point - 1 );
+}
+
+template <typename T>
+inline char* format_floating(char* buffer, T value)
+{
+    if( value != value )
+    {
+        std::memcpy( buffer, "nan", 3 );
+        return buffer + 3;
+    }
+    if( std::signbit( value ) )
+    {
+        *buffer++ = '-';
+        value = -value;
+    }
+    if( value == std::numeric_limits<T>::infinity() )
+    {
+        std::memcpy( buffer, "inf", 3 );
+        return buffer + 3;
+    }
+    if( value == T(0) )
+    {
+        *buffer = '0';
+        return buffer + 1;
+    }
+    int length = 0;
+    int exponent = 0;
+    grisu2( buffer, length, exponent, value );
+    return format_decimal( buffer, length, exponent );
+}
+
+template <typename T>
+inline char* format_number(char* buffer, T value, std::true_type /*integral*/)
+{
+    return std::is_signed<T>::value ? format_signed( buffer, static_cast<int64_t>(value) )
+                                    : format_unsigned( buffer, static_cast<uint64_t>(value) );
+}
+
+template <typename T>
+inline char* format_number(char* buffer, T value, std::false_type /*floating point*/)
+{
+    return format_floating( buffer, value );
+}
+
+//----------------------- Parsing ----------------------------------------------
+
+// A number read from a string, before its conversion to the destination type.
+struct ParsedNumber
+{
+    enum Kind : uint8_t
+    {
+        INVALID = 1,   // not a number (0 is reserved for "not parsed yet")
+        UNSIGNED,      // integer >= 0, in u
+        SIGNED,        // negative integer, in i
+        FLOATING,      // with a decimal point or an exponent, or too large for 64 bits, in d
+        OUT_OF_RANGE,  // beyond the range of double, +/- infinity in d
+        BOOLEAN        // "true" or "false", in u
+    };
+
+    Kind kind;
+    union
+    {
+        uint64_t u;
+        int64_t i;
+        double d;
+    };
+};
+
+// Case-insensitive comparison with the lowercase "word".
+inline bool match_word(const char* first, const char* last, const char* word)
+{
+    const std::size_t size = std::strlen( word );
+    if( static_cast<std::size_t>( last - first ) != size ) { return false; }
+    for(std::size_t i=0; i<size; i++)
+    {
+        if( (first[i] | 0x20) != word[i] ) { return false; }
+    }
+    return true;
+}
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Correctly rounded, through strtod(). The text (already validated) is rewritten
+// as digits and exponent, without the decimal point: the result doesn't depend
+// on the locale. Beyond the 770 significant digits that can affect the rounding,
+// a sticky digit is kept.
+inline double parse_double_slow(const char* first, const char* last, bool negative)
+{
+    char buffer[800];
+    std::size_t size = 0;
+    int exponent = 0;
+    bool fraction = false;
+    bool dropped_nonzero = false;
+    const char* ptr = first;
+    for(; ptr != last && *ptr != 'e' && *ptr != 'E'; ptr++)
+    {
+        if( *ptr == '.' ) { fraction = true; continue; }
+        if( size == 0 && *ptr == '0' )
+        {
+            if( fraction ) { exponent--; }
+            continue;
+        }
+        if( size < 770 )
+        {
+            buffer[size++] = *ptr;
+            if( fraction ) { exponent--; }
+        }
+        else
+        {
+            dropped_nonzero |= ( *ptr != '0' );
+            if( !fraction ) { exponent++; }
+        }
+    }
+    if( size == 0 ) { return negative ? -0.0 : 0.0; }
+    if( dropped_nonzero ) { buffer[size++] = '1'; exponent--; }
+
+    if( ptr != last )
+    {
+        ptr++;
+        const bool exp_negative = ( *ptr == '-' );
+        if( *ptr == '-' || *ptr == '+' ) { ptr++; }
+        int exp10 = 0;
+        for(; ptr != last; ptr++)
+        {
+            if( exp10 < 100000 ) { exp10 = exp10 * 10 + (*ptr - '0'); }
+        }
+        exponent += exp_negative ? -exp10 : exp10;
+    }
+    buffer[size++] = 'e';
+    char* end = format_signed( buffer + size, exponent );
+    *end = '\0';
+    const double value = std::strtod( buffer, nullptr );
+    return negative ? -value : value;
+}
+
+// Syntax: [+-]digits[.digits][(e|E)[+-]digits], with at least one digit before or
+// after the point; "inf", "infinity" and "nan" with an optional sign; "true" and
+// "false". The whole text must match, spaces included.
+inline ParsedNumber parse_number(const char* first, const char* last)
+{
+    ParsedNumber result;
+    result.kind = ParsedNumber::INVALID;
+    result.u = 0;
+
+    if( match_word( first, last, "true" ) || match_word( first, last, "false" ) )
+    {
+        result.kind = ParsedNumber::BOOLEAN;
+        result.u = ( (first[0] | 0x20) == 't' ) ? 1 : 0;
+        return result;
+    }
+
+    const bool negative = ( first != last && *first == '-' );
+    if( first != last && (*first == '-' || *first == '+') ) { first++; }
+
+    if( match_word( first, last, "inf" ) || match_word( first, last, "infinity" ) ||
+        match_word( first, last, "nan" ) )
+    {
+        result.kind = ParsedNumber::FLOATING;
+        result.d = ( (first[0] | 0x20) == 'n' ) ? std::numeric_limits<double>::quiet_NaN()
+                                                : std::numeric_limits<double>::infinity();
+        if( negative ) { result.d = -result.d; }
+        return result;
+    }
+
+    // the digits are accumulated as long as they fit 64 bits
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool overflow = false;
+    bool any_digit = false;
+    bool integral = true;
+    const char* ptr = first;
+    for(; ptr != last && is_digit(*ptr); ptr++)
+    {
+        const unsigned digit = static_cast<unsigned>( *ptr - '0' );
+        any_digit = true;
+        if( !overflow && mantissa <= (std::numeric_limits<uint64_t>::max() - digit) / 10 ) {
+            mantissa = mantissa * 10 + digit;
+        }
+        else {
+            overflow = true;
+        }
+    }
+    if( ptr != last && *ptr == '.' )
+    {
+        integral = false;
+        for(ptr++; ptr != last && is_digit(*ptr); ptr++)
+        {
+            const unsigned digit = static_cast<unsigned>( *ptr - '0' );
+            any_digit = true;
+            if( !overflow && mantissa <= (std::numeric_limits<uint64_t>::max() - digit) / 10 ) {
+                mantissa = mantissa * 10 + digit;
+                exponent--;
+            }
+            else {
+                overflow = true;
+            }
+        }
+    }
+    if( !any_digit ) { return result; }
+
+    if( ptr != last && (*ptr == 'e' || *ptr == 'E') )
+    {
+        integral = false;
+        ptr++;
+        const bool exp_negative = ( ptr != last && *ptr == '-' );
+        if( ptr != last && (*ptr == '-' || *ptr == '+') ) { ptr++; }
+        if( ptr == last ) { return result; }
+        int exp10 = 0;
+        for(; ptr != last && is_digit(*ptr); ptr++)
+        {
+            if( exp10 < 100000 ) { exp10 = exp10 * 10 + (*ptr - '0'); }
+        }
+        exponent += exp_negative ? -exp10 : exp10;
+    }
+    if( ptr != last ) { return result; }
+
+    const uint64_t sign_limit = uint64_t(1) << 63;
+    if( integral && !overflow && (!negative || mantissa <= sign_limit) )
+    {
+        if( negative && mantissa != 0 )
+        {
+            result.kind = ParsedNumber::SIGNED;
+            result.i = ( mantissa == sign_limit ) ? std::numeric_limits<int64_t>::min()
+                                                  : -static_cast<int64_t>( mantissa );
+        }
+        else
+        {
+            result.kind = ParsedNumber::UNSIGNED;
+            result.u = mantissa;
+        }
+        return result;
+    }
+
+    result.kind = ParsedNumber::FLOATING;
+    // both the mantissa and 10^exponent are exact doubles: one correctly rounded operation
+    static const double powers10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                       1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                                       1e20, 1e21, 1e22 };
+    if( !overflow && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22 )
+    {
+        const double value = static_cast<double>( mantissa );
+        result.d = ( exponent < 0 ) ? value / powers10[-exponent] : value * powers10[exponent];
+        if( negative ) { result.d = -result.d; }
+        return result;
+    }
+    result.d = parse_double_slow( first, last, negative );
+    if( std::isinf( result.d ) ) { result.kind = ParsedNumber::OUT_OF_RANGE; }
+    return result;
+}
+
+} // end namespace details
+
+template <typename T> inline
+char* formatNumber(char* buffer, T value)
+{
+    static_assert( std::is_arithmetic<T>::value, "formatNumber() requires a number" );
+    return details::format_number( buffer, value, std::is_integral<T>() );
+}
+
+} // end namespace SafeAny
+
+#endif // SAFE_ANY_NUMBER_FORMAT_H
@@ -3,38 +3,113 @@
 
 #include <exception>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <chrono>
 #include <string>
 #include <cstring>
+#include <limits>
+#include <vector>
 #include "any.hpp"
+#include "number_any.hpp"
+#include "number_format.hpp"
+
+// The conversion engine can be compiled with -fno-exceptions: tryConvert() reports
+// the errors as ConversionError, while the functions that would throw call std::abort().
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define SAFE_ANY_THROW(exception) throw exception
+#else
+#define SAFE_ANY_THROW(exception) std::abort()
+#endif
 
 namespace SafeAny{
 
 // Version of string that uses only two words. Good for small object optimization in linb::any
+//
+// The buffer starts with the memory_resource it was allocated from (nullptr: default heap)
+// and its capacity, so that the string can live in an arena and be assigned in place
+// without making the object bigger. The header also caches the number written in
+// the string, parsed by Any::tryParse().
 class SimpleString
 {
 public:
-    SimpleString(const std::string& str): SimpleString(str.data(), str.size())
+    SimpleString(const std::string& str, linb::memory_resource* resource = nullptr):
+        SimpleString(str.data(), str.size(), resource)
     { }
     SimpleString(const char* data): SimpleString( data, strlen(data) )
     { }
 
-    SimpleString(const char* data, std::size_t size): _size(size)
+    SimpleString(const char* data, std::size_t size, linb::memory_resource* resource = nullptr): _size(size)
     {
-        _data = new char[_size+1];
-        strncpy(_data, data, _size);
+        _data = allocate(size, resource);
+        memcpy(_data, data, _size);
         _data[_size] = '\0';
     }
 
     SimpleString(const SimpleString& other): SimpleString(other.data(), other.size())
     { }
 
+    // Copy allocated from "resource" (see linb::detail::uses_memory_resource).
+    SimpleString(std::allocator_arg_t, linb::memory_resource* resource, const SimpleString& other):
+        SimpleString(other.data(), other.size(), resource)
+    { }
+
+    SimpleString(SimpleString&& other) noexcept: _data(other._data), _size(other._size)
+    {
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    SimpleString& operator=(const SimpleString& other)
+    {
+        if( this != &other ) { assign(other.data(), other.size()); }
+        return *this;
+    }
+
+    SimpleString& operator=(SimpleString&& other) noexcept
+    {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        return *this;
+    }
+
+    // The number written in the string (see details::parse_number()). It is parsed
+    // only the first time and stored in the buffer; concurrent calls are safe.
+    details::ParsedNumber parsedNumber() const
+    {
+        if( !_data ) { return details::parse_number(nullptr, nullptr); }
+
+        details::ParsedNumber number;
+        const uint8_t kind = header()->parsed_kind.load( std::memory_order_acquire );
+        if( kind != 0 )
+        {
+            number.kind = static_cast<details::ParsedNumber::Kind>(kind);
+            number.u = header()->parsed_bits.load( std::memory_order_relaxed );
+            return number;
+        }
+        number = details::parse_number( _data, _data + _size );
+        header()->parsed_bits.store( number.u, std::memory_order_relaxed );
+        header()->parsed_kind.store( number.kind, std::memory_order_release );
+        return number;
+    }
 
     ~SimpleString() {
-        if(_data){
-            delete[] _data;
+        release();
+    }
+
+    // The current buffer is reused if it is large enough.
+    void assign(const char* data, std::size_t size)
+    {
+        if( !_data || size > header()->capacity )
+        {
+            char* buffer = allocate(size, resource());
+            release();
+            _data = buffer;
         }
+        memmove(_data, data, size);
+        _size = size;
+        _data[_size] = '\0';
+        header()->parsed_kind.store( 0, std::memory_order_relaxed );
     }
 
     std::string toStdString() const
@@ -46,49 +121,550 @@ public:
 
     std::size_t size() const { return _size;}
 
+    std::size_t capacity() const { return _data ? header()->capacity : 0; }
+
+    linb::memory_resource* resource() const
+    {
+        return _data ? header()->resource : nullptr;
+    }
+
 private:
+    struct Header
+    {
+        Header(linb::memory_resource* res, std::size_t cap):
+            resource(res), capacity(cap), parsed_bits(0), parsed_kind(0)
+        {}
+
+        linb::memory_resource* resource;
+        std::size_t capacity;
+        // details::ParsedNumber, kind 0 if not parsed yet
+        mutable std::atomic<uint64_t> parsed_bits;
+        mutable std::atomic<uint8_t> parsed_kind;
+    };
+
+    const Header* header() const { return reinterpret_cast<const Header*>(_data - sizeof(Header)); }
+
+    static std::size_t bufferSize(std::size_t capacity) { return sizeof(Header) + capacity + 1; }
+
+    static char* allocate(std::size_t capacity, linb::memory_resource* resource)
+    {
+        void* buffer = linb::detail::allocate( resource, bufferSize(capacity), alignof(Header) );
+        new (buffer) Header( resource, capacity );
+        return static_cast<char*>(buffer) + sizeof(Header);
+    }
+
+    void release()
+    {
+        if(_data){
+            linb::detail::deallocate( header()->resource, _data - sizeof(Header),
+                                      bufferSize(header()->capacity), alignof(Header) );
+            _data = nullptr;
+        }
+    }
+
     char* _data;
     std::size_t _size;
 };
 
 
 
+namespace details{
+
+// Values that Any can take by move: std::string and C strings are always
+// copied into a SimpleString instead.
+template <typename T>
+struct is_movable_value : std::integral_constant<bool,
+        !std::is_lvalue_reference<T>::value
+        && !std::is_same<typename std::decay<T>::type, std::string>::value
+        && !std::is_same<typename std::decay<T>::type, const char*>::value
+        && !std::is_same<typename std::decay<T>::type, char*>::value>
+{};
+
+template <typename T, typename Self>
+using EnableIfMovable = typename std::enable_if< is_movable_value<T>::value
+        && !std::is_same<typename std::decay<T>::type, Self>::value >::type;
+
+} // end namespace details
+
+// Result of Any::tryConvert() and Blackboard::tryGet().
+enum class ConversionError : uint8_t
+{
+    Ok = 0,
+    TooLarge,
+    TooSmall,
+    Negative,
+    Truncated,
+    NotConvertible,    // the destination is not a number nor a string
+    StringToNumber,    // strings are not converted to numbers implicitly
+    NotAString,        // the value can't be converted to std::string
+    TypeMismatch,      // the value is not a number nor a string, and its type is not the destination
+    InvalidNumber,     // Any::tryParse(): the string is not a number
+    MissingKey         // Blackboard::tryGet() only
+};
+
+inline const char* toString(ConversionError error)
+{
+    switch( error )
+    {
+    case ConversionError::Ok:             return "Ok";
+    case ConversionError::TooLarge:       return "Value too large.";
+    case ConversionError::TooSmall:       return "Value too small.";
+    case ConversionError::Negative:       return "Value is negative and can't be converted to signed";
+    case ConversionError::Truncated:      return "Floating point truncated";
+    case ConversionError::NotConvertible: return "Not convertible";
+    case ConversionError::StringToNumber: return "String can not be converted to another type implicitly";
+    case ConversionError::NotAString:     return "Conversion to std::string failed";
+    case ConversionError::TypeMismatch:   return "bad any cast";
+    case ConversionError::InvalidNumber:  return "String is not a number";
+    case ConversionError::MissingKey:     return "Key not found";
+    }
+    return "Unknown conversion error";
+}
+
+namespace details{
+
+// The exception thrown by convert() for the given error.
+// TypeMismatch is a linb::bad_any_cast, the others std::runtime_error.
+[[noreturn]] inline void throwConversionError(ConversionError error)
+{
+    if( error == ConversionError::TypeMismatch ) {
+        SAFE_ANY_THROW( linb::bad_any_cast() );
+    }
+    SAFE_ANY_THROW( std::runtime_error( toString(error) ) );
+}
+
+} // end namespace details
+
+class Any;
+
+namespace details{
+struct range_access;
+}
+
+// Converts the numbers in [first, last) to DST, writing the results into out
+// (which must have room for last - first values). The values are grouped by
+// type and each group is converted by a loop without branches, that the
+// compiler vectorizes; the checks are the same of Any::tryConvert().
+//
+// Returns the number of values that couldn't be converted: their indexes are
+// appended to "failed" (if not nullptr), in ascending order, and the
+// corresponding elements of out are not modified. Nothing is thrown.
+template <typename DST>
+std::size_t convertRange(const Any* first, const Any* last, DST* out,
+                         std::vector<std::size_t>* failed = nullptr);
+
+// Type-erased value.
+//
+// The numbers (bool, char, intN_t, uintN_t, float and double) are stored in a
+// NumberAny: copying, reading and converting them never goes through linb::any.
+// The NumberAny and the linb::any share the same storage, the flag telling which
+// one is active makes the Any 8 bytes larger than a linb::any (32 bytes instead
+// of 24 on 64 bits): the price of numbers without vtable, heap or typeid. No byte
+// is unused by both members, where the flag could be hidden; containers of
+// millions of numbers can use CompactAny (16 bytes) instead.
+//
+// Move-only types (e.g. std::unique_ptr) can be stored, moving them into the Any;
+// copying such an Any throws linb::bad_any_copy.
+//
+// Large values can be stored with makeShared(): they become immutable and all the
+// copies of the Any refer to the same object.
 class Any
 {
 
 public:
 
-    Any() {}
+    Any(): _is_number(true)
+    {
+        initNumber( NumberAny() );
+    }
 
-    ~Any() = default;
+    ~Any()
+    {
+        if( !_is_number ) { _any.~any(); }
+    }
 
-    template<typename T> Any(const T& value) : _any(value)
-    { }
+    Any(const Any& other): _is_number(other._is_number)
+    {
+        if( _is_number ) { initNumber( other._number ); }
+        else             { new (&_any) linb::any(other._any); }
+    }
+
+    Any(Any&& other) noexcept: _is_number(other._is_number)
+    {
+        if( _is_number ) { initNumber( other._number ); }
+        else             { new (&_any) linb::any( std::move(other._any) ); }
+    }
+
+    Any& operator=(const Any& other)
+    {
+        if( _is_number && other._is_number ) { _number = other._number; }
+        else if( !_is_number && !other._is_number ) { _any = other._any; }
+        else { *this = Any(other); }
+        return *this;
+    }
+
+    Any& operator=(Any&& other) noexcept
+    {
+        if( _is_number && other._is_number ) { _number = other._number; }
+        else if( !_is_number && !other._is_number ) { _any = std::move(other._any); }
+        else
+        {
+            this->~Any();
+            new (this) Any( std::move(other) );
+        }
+        return *this;
+    }
+
+    template<typename T> Any(const T& value)
+    {
+        construct( value, details::is_stored_as_number<T>() );
+    }
+
+    template<typename T, typename = details::EnableIfMovable<T, Any>>
+    Any(T&& value)
+    {
+        construct( std::move(value), details::is_stored_as_number<typename std::decay<T>::type>() );
+    }
+
+    // Copy of "other" whose heap payload (if any) is allocated from "resource".
+    Any(std::allocator_arg_t, linb::memory_resource* resource, const Any& other):
+        _is_number(other._is_number)
+    {
+        if( _is_number ) { initNumber( other._number ); }
+        else             { new (&_any) linb::any(std::allocator_arg, resource, other._any); }
+    }
+
+    // Store "value" in an immutable, reference-counted block: copying the Any (as done
+    // by the blackboards, e.g. BlackboardConcurrent::get() or the transactions) costs
+    // the same whatever the size of the value. Meant for large values that are replaced
+    // rather than modified: assignInPlace() returns false and extractMutablePtr() nullptr.
+    template<typename T> static Any makeShared(T&& value)
+    {
+        typedef typename std::decay<T>::type U;
+        Any out;
+        out.anyStorage() = makeSharedImpl( std::is_same<U, std::string>(), std::forward<T>(value) );
+        return out;
+    }
+
+    bool isShared() const { return !_is_number && _any.is_shared(); }
+
+    // False for the move-only types, whose copy throws linb::bad_any_copy.
+    bool isCopyable() const { return _is_number || _any.is_copyable(); }
 
     template<typename T> T convert( ) const;
 
+    // Same as dst = convert<T>(), but when the stored value has type T it is
+    // copy-assigned, reusing the memory of dst (capacity of vectors and strings).
+    template<typename T> void convertTo(T& dst) const
+    {
+        const ConversionError error = tryConvert(dst);
+        if( error != ConversionError::Ok ) { details::throwConversionError(error); }
+    }
+
+    // Same as convertTo(), but the errors are returned instead of thrown: a failed
+    // conversion is cheap (no exception, no allocation) and leaves dst unchanged.
+    template<typename T> ConversionError tryConvert(T& dst) const;
+
+    // Opt-in conversion of strings to numbers, as SafeAny::parseNumber() does
+    // ("42", "-1.5e3", "true"). The parsed number is cached in the SimpleString:
+    // reading the same value again doesn't parse it again.
+    // The other values are converted as tryConvert() does.
+    template<typename T> ConversionError tryParse(T& dst) const;
+
+    template<typename T> T parse() const
+    {
+        T out;
+        const ConversionError error = tryParse(out);
+        if( error != ConversionError::Ok ) { details::throwConversionError(error); }
+        return out;
+    }
+
+    // If the stored value has type T, assign "value" to it in place and return
+    // true, otherwise return false. Strings are assigned to the stored SimpleString.
+    template<typename T> bool assignInPlace(const T& value)
+    {
+        T* ptr = extractMutablePtr<T>();
+        if( !ptr ) { return false; }
+        *ptr = value;
+        return true;
+    }
+
+    // Move-assignment, when "value" is an rvalue. Nothing is moved if it returns false.
+    template<typename T, typename = details::EnableIfMovable<T, Any>>
+    bool assignInPlace(T&& value)
+    {
+        typedef typename std::decay<T>::type U;
+        U* ptr = extractMutablePtr<U>();
+        if( !ptr ) { return false; }
+        *ptr = std::move(value);
+        return true;
+    }
+
+    bool assignInPlace(const char* value)
+    {
+        SimpleString* ptr = extractMutablePtr<SimpleString>();
+        if( !ptr ) { return false; }
+        ptr->assign(value, strlen(value));
+        return true;
+    }
+
+    // Same as above, if "other" contains the same type.
+    bool assignInPlace(const Any& other)
+    {
+        if( _is_number != other._is_number ) { return false; }
+        if( !_is_number ) { return _any.assign_in_place(other._any); }
+        if( _number.typeId() != other._number.typeId() ) { return false; }
+        _number = other._number;
+        return true;
+    }
+
+    // Replace the stored value with T(args...), constructed in place.
+    // A std::string is stored as SimpleString, like in the constructor.
+    template<typename T, typename... Args> void emplace(Args&&... args)
+    {
+        emplaceImpl<T>( std::is_same<T, std::string>(), std::forward<Args>(args)... );
+    }
+
+    // Pointer to the stored value if its type is exactly T, nullptr otherwise
+    // (also if it is shared). Move-only values can be modified or moved out through it.
+    template<typename T> T* extractMutablePtr( )
+    {
+        return _is_number ? _number.get<T>() : linb::any_cast<T>(&_any);
+    }
+
+    // True if the stored value is arithmetic (or empty): it can be copied without allocating memory.
+    bool isArithmetic() const { return typeId() < linb::detail::type_registry::first_user_id; }
+
     template<typename T> T extract( ) const
     {
-        return linb::any_cast<T>(_any);
+        const T* ptr = extractPtr<T>();
+        if( !ptr ) { SAFE_ANY_THROW( linb::bad_any_cast() ); }
+        return *ptr;
+    }
+
+    // Pointer to the stored value if its type is exactly T, nullptr otherwise. No copy is done.
+    template<typename T> const T* extractPtr( ) const
+    {
+        return _is_number ? _number.get<T>() : linb::any_cast<T>(&_any);
     }
 
-    const std::type_info& type() const { return _any.type(); }
+    const std::type_info& type() const { return _is_number ? _number.type() : _any.type(); }
+
+    // Id of the stored type in the process-wide registry, see linb::detail::type_registry
+    uint32_t typeId() const { return _is_number ? _number.typeId() : _any.type_id(); }
+
+    // The stored number (or nothing, if empty); nullptr for the other values and the shared numbers.
+    const NumberAny* number() const { return _is_number ? &_number : nullptr; }
 
 private:
 
-    linb::any _any;
+    friend struct details::range_access;
+
+    template<typename T> void construct(const T& value, std::true_type)
+    {
+        initNumber( NumberAny(value) );
+        _is_number = true;
+    }
+
+    // NumberAny takes 16 bytes of the union, the pointer to the vtable of linb::any
+    // the other 8: that is left null, so that the whole union is always initialized
+    // (otherwise GCC reports that the vtable read by ~any() "may be used uninitialized",
+    // not seeing that _is_number excludes it).
+    void initNumber(const NumberAny& number)
+    {
+        new (&_any) linb::any();
+        new (&_number) NumberAny(number);
+    }
+
+    template<typename T> void construct(T&& value, std::false_type)
+    {
+        new (&_any) linb::any( std::forward<T>(value) );
+        _is_number = false;
+    }
+
+    // The linb::any, constructed (empty) if a number was stored.
+    linb::any& anyStorage()
+    {
+        if( _is_number )
+        {
+            new (&_any) linb::any();
+            _is_number = false;
+        }
+        return _any;
+    }
+
+    template<typename T> T convertImpl(std::true_type) const
+    {
+        T out;
+        convertTo(out);
+        return out;
+    }
+
+    // Not a number nor a string: no conversion.
+    template<typename T> T convertImpl(std::false_type) const
+    {
+        return extract<T>();
+    }
+
+    template<typename T> ConversionError tryParseImpl(T& dst, std::false_type) const
+    {
+        return tryConvert(dst);
+    }
+
+    template<typename T> ConversionError tryParseImpl(T& dst, std::true_type) const;
+
+    template<typename T> ConversionError tryConvertVector(T&, std::false_type) const
+    {
+        return ConversionError::TypeMismatch;
+    }
+
+    template<typename T> ConversionError tryConvertVector(std::vector<T>& dst, std::true_type) const;
+
+    template<typename T> static linb::any makeSharedImpl(std::false_type, T&& value)
+    {
+        return linb::any( linb::shared_payload, std::forward<T>(value) );
+    }
+
+    static linb::any makeSharedImpl(std::true_type, const std::string& str)
+    {
+        return linb::any( linb::shared_payload, SimpleString(str) );
+    }
+
+    template<typename T, typename... Args> void emplaceImpl(std::false_type, Args&&... args)
+    {
+        emplaceValue<T>( details::is_tagged_number<T>(), std::forward<Args>(args)... );
+    }
+
+    template<typename T, typename... Args> void emplaceImpl(std::true_type, Args&&... args)
+    {
+        const std::string str( std::forward<Args>(args)... );
+        linb::any& any = anyStorage();
+        any.emplace<SimpleString>( str.data(), str.size(), any.resource() );
+    }
+
+    template<typename T, typename... Args> void emplaceValue(std::true_type, Args&&... args)
+    {
+        const T value( std::forward<Args>(args)... );
+        if( !_is_number )
+        {
+            _any.~any();
+            initNumber( NumberAny() );
+            _is_number = true;
+        }
+        _number.set( value );
+    }
+
+    template<typename T, typename... Args> void emplaceValue(std::false_type, Args&&... args)
+    {
+        anyStorage().emplace<T>( std::forward<Args>(args)... );
+    }
+
+    union
+    {
+        NumberAny _number;
+        linb::any _any;
+    };
+    bool _is_number;
 };
 
 //----------------------------------------------
 //specialization for std::string
-template <> inline Any::Any(const std::string& str)
+template <> inline Any::Any(const std::string& str): _is_number(false)
 {
-    _any = linb::any(SimpleString(str));
+    new (&_any) linb::any(SimpleString(str));
 }
 
 template <> inline std::string Any::extract() const
 {
-    return linb::any_cast<SimpleString>(_any).toStdString();
+    const SimpleString* ptr = extractPtr<SimpleString>();
+    if( !ptr ) { SAFE_ANY_THROW( linb::bad_any_cast() ); }
+    return ptr->toStdString();
+}
+
+template <> inline ConversionError Any::tryConvert(std::string& dst) const;
+
+template <> inline ConversionError NumberAny::tryConvert(std::string& dst) const;
+
+template <> inline bool Any::assignInPlace(const std::string& value)
+{
+    SimpleString* ptr = extractMutablePtr<SimpleString>();
+    if( !ptr ) { return false; }
+    ptr->assign(value.data(), value.size());
+    return true;
+}
+
+// How a value of type SRC (as stored in Any) is converted to DST.
+enum class ConversionKind : uint8_t
+{
+    Identity,          // same type
+    Widening,          // every value of SRC is represented exactly: no check
+    CheckedNarrowing,  // checked at run-time, it might fail
+    Impossible         // always fails
+};
+
+namespace details{
+
+// char is converted as int8_t
+template <typename T>
+struct canonical_number
+{
+    typedef typename std::conditional<std::is_same<T, char>::value, int8_t, T>::type type;
+};
+
+template <typename T>
+struct is_string : std::integral_constant<bool,
+        std::is_same<T, std::string>::value || std::is_same<T, SimpleString>::value>
+{};
+
+// std::vector of numbers, bool and char excluded
+template <typename T>
+struct is_number_vector : std::false_type
+{
+    typedef T value_type;
+};
+
+template <typename T>
+struct is_number_vector< std::vector<T> > : std::integral_constant<bool,
+        std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>
+{
+    typedef T value_type;
+};
+
+// SRC and DST are canonical arithmetic types.
+template <typename SRC, typename DST>
+constexpr ConversionKind numberConversionKind()
+{
+    return std::is_same<SRC, DST>::value ? ConversionKind::Identity :
+           std::is_same<SRC, bool>::value ? ConversionKind::Widening :
+           std::is_same<DST, bool>::value ? ConversionKind::Impossible :
+           ( std::is_integral<SRC>::value && std::is_integral<DST>::value ) ?
+               ( ( sizeof(SRC) < sizeof(DST) && (std::is_signed<DST>::value || !std::is_signed<SRC>::value) ) ?
+                     ConversionKind::Widening : ConversionKind::CheckedNarrowing ) :
+           ( std::is_floating_point<DST>::value &&
+             std::numeric_limits<SRC>::digits <= std::numeric_limits<DST>::digits ) ? ConversionKind::Widening :
+           ConversionKind::CheckedNarrowing;
+}
+
+} // end namespace details
+
+// Compile-time table of the conversions done by Any::convert() and Any::tryConvert().
+// Numbers are never converted implicitly to bool, strings never to numbers, and
+// the other types only to themselves. A vector of numbers is converted to another
+// one element by element (every element must be convertible).
+template <typename SRC, typename DST>
+constexpr ConversionKind conversionKind()
+{
+    return std::is_same<SRC, DST>::value ? ConversionKind::Identity :
+           ( details::is_number_vector<SRC>::value && details::is_number_vector<DST>::value ) ?
+               details::numberConversionKind< typename details::is_number_vector<SRC>::value_type,
+                                              typename details::is_number_vector<DST>::value_type >() :
+           details::is_string<SRC>::value ?
+               ( std::is_same<DST, std::string>::value ? ConversionKind::Identity : ConversionKind::Impossible ) :
+           !std::is_arithmetic<SRC>::value ? ConversionKind::Impossible :
+           std::is_same<DST, std::string>::value ? ConversionKind::Widening :
+           !std::is_arithmetic<DST>::value ? ConversionKind::Impossible :
+           details::numberConversionKind< typename details::canonical_number<SRC>::type,
+                                          typename details::canonical_number<DST>::type >();
 }
 
 namespace details{
@@ -210,289 +786,971 @@ struct integer_to_floating_conversion
         && std::is_floating_point<To>::value >
 {};
 
+//----------------------- Checks ----------------------------------------------
+// ConversionError::Ok if "from" can be represented as To.
+
 template <typename From, typename To>
-inline void checkUpperLimit(const From& from)
+inline ConversionError checkUpperLimit(const From& from)
 {
-    if ((sizeof(To) < sizeof(From)) &&
+    // e.g. uint32_t to int32_t: the maximum of To is representable as From
+    if ((std::numeric_limits<To>::digits < std::numeric_limits<From>::digits) &&
             (from > static_cast<From>(std::numeric_limits<To>::max()))) {
-        throw std::runtime_error("Value too large.");
+        return ConversionError::TooLarge;
     }
     else if (static_cast<To>(from) > std::numeric_limits<To>::max()) {
-        throw std::runtime_error("Value too large.");
+        return ConversionError::TooLarge;
     }
+    return ConversionError::Ok;
 }
 
 template <typename From, typename To>
-inline void checkUpperLimitFloat(const From& from)
+inline ConversionError checkUpperLimitFloat(const From& from)
 {
-    if (from > std::numeric_limits<To>::max()){
-        throw std::runtime_error("Value too large.");
+    // max() of the integer To is 2^digits - 1, rounded to 2^digits by a float or a double
+    if (from >= static_cast<From>(std::numeric_limits<To>::max()) + From(1)){
+        return ConversionError::TooLarge;
     }
+    return ConversionError::Ok;
 }
 
 template <typename From, typename To>
-inline void checkLowerLimitFloat(const From& from)
+inline ConversionError checkLowerLimitFloat(const From& from)
 {
-    if (from < -std::numeric_limits<To>::max()){
-        throw std::runtime_error("Value too small.");
+    if (from < static_cast<From>(std::numeric_limits<To>::lowest())){
+        return ConversionError::TooSmall;
     }
+    return ConversionError::Ok;
 }
 
 template <typename From, typename To>
-inline void checkLowerLimit(const From& from)
+inline ConversionError checkLowerLimit(const From& from)
 {
     if (from < std::numeric_limits<To>::min()){
-        throw std::runtime_error("Value too small.");
+        return ConversionError::TooSmall;
     }
+    return ConversionError::Ok;
+}
+
+// 2^digits of DST, exactly representable by the floating point SRC.
+template <typename SRC, typename DST>
+constexpr SRC upper_bound_of()
+{
+    return SRC(2) * static_cast<SRC>( uint64_t(1) << (std::numeric_limits<DST>::digits - 1) );
 }
 
 template <typename From, typename To>
-inline void checkTruncation(const From& from)
+inline ConversionError checkTruncation(const From& from)
 {
     if( from != static_cast<From>(static_cast<To>( from))){
-        throw std::runtime_error("Floating point truncated");
+        return ConversionError::Truncated;
     }
+    return ConversionError::Ok;
 }
 
+#define SAFE_ANY_CHECK(expression) \
+    { const ConversionError error = (expression); if( error != ConversionError::Ok ) { return error; } }
+
 
 //----------------------- Implementation ----------------------------------------------
+// target is assigned only if the conversion succeeds.
+
+template <typename BoolCondition>
+using EnableIfResult = typename std::enable_if< BoolCondition::value, ConversionError>::type;
 
 template<typename SRC,typename DST> inline
-typename std::enable_if< !is_convertible_type<DST>::value, void>::type
+typename std::enable_if< !is_convertible_type<DST>::value, ConversionError>::type
 convert_impl( const SRC& , DST&  )
 {
-    throw std::runtime_error("Not convertible");
+    return ConversionError::NotConvertible;
 }
 
 
 template<typename SRC,typename DST> inline
-EnableIf< std::is_same<SRC, DST>>
+EnableIfResult< std::is_same<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
     target = from;
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< is_safe_integer_conversion<SRC, DST>>
+EnableIfResult< is_safe_integer_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< float_conversion<SRC, DST>>
+EnableIfResult< float_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkTruncation<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkTruncation<SRC,DST>(from)) );
     target = static_cast<DST>( from );
+    return ConversionError::Ok;
 }
 
 
 template<typename SRC,typename DST> inline
-EnableIf< unsigned_to_smaller_conversion<SRC, DST>>
+EnableIfResult< unsigned_to_smaller_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkUpperLimit<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkUpperLimit<SRC,DST>(from)) );
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< signed_to_smaller_conversion<SRC, DST>>
+EnableIfResult< signed_to_smaller_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkLowerLimit<SRC,DST>(from);
-    checkUpperLimit<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkLowerLimit<SRC,DST>(from)) );
+    SAFE_ANY_CHECK( (checkUpperLimit<SRC,DST>(from)) );
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 
 template<typename SRC,typename DST> inline
-EnableIf< signed_to_smaller_unsigned_conversion<SRC, DST>>
+EnableIfResult< signed_to_smaller_unsigned_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
     if (from < 0 )
-        throw std::runtime_error("Value is negative and can't be converted to signed");
+        return ConversionError::Negative;
 
-    checkUpperLimit<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkUpperLimit<SRC,DST>(from)) );
     target = static_cast<DST>( from );
+    return ConversionError::Ok;
 }
 
 
 template<typename SRC,typename DST> inline
-EnableIf< signed_to_larger_unsigned_conversion<SRC, DST>>
+EnableIfResult< signed_to_larger_unsigned_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "signed_to_larger_unsigned_conversion" << std::endl;
-
     if ( from < 0 )
-        throw std::runtime_error("Value is negative and can't be converted to signed");
+        return ConversionError::Negative;
 
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< unsigned_to_larger_signed_conversion<SRC, DST>>
+EnableIfResult< unsigned_to_larger_signed_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    //std::cout << "unsigned_to_larger_signed_conversion" << std::endl;
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< unsigned_to_smaller_signed_conversion<SRC, DST>>
+EnableIfResult< unsigned_to_smaller_signed_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkUpperLimit<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkUpperLimit<SRC,DST>(from)) );
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< floating_to_signed_conversion<SRC, DST>>
+EnableIfResult< floating_to_signed_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkLowerLimitFloat<SRC,DST>(from);
-    checkLowerLimitFloat<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkLowerLimitFloat<SRC,DST>(from)) );
+    SAFE_ANY_CHECK( (checkUpperLimitFloat<SRC,DST>(from)) );
 
     if( from != static_cast<SRC>(static_cast<DST>( from)))
-        throw std::runtime_error("Floating point truncated");
+        return ConversionError::Truncated;
 
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< floating_to_unsigned_conversion<SRC, DST>>
+EnableIfResult< floating_to_unsigned_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
     if ( from < 0 )
-        throw std::runtime_error("Value is negative and can't be converted to signed");
+        return ConversionError::Negative;
 
-    checkLowerLimitFloat<SRC,DST>(from);
+    SAFE_ANY_CHECK( (checkUpperLimitFloat<SRC,DST>(from)) );
 
     if( from != static_cast<SRC>(static_cast<DST>( from)))
-        throw std::runtime_error("Floating point truncated");
+        return ConversionError::Truncated;
 
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
 template<typename SRC,typename DST> inline
-EnableIf< integer_to_floating_conversion<SRC, DST>>
+EnableIfResult< integer_to_floating_conversion<SRC, DST>>
 convert_impl( const SRC& from, DST& target )
 {
-    checkTruncation<SRC,DST>(from);
+    // rounded up to 2^digits of SRC: the cast back, in checkTruncation(), would be undefined
+    if( static_cast<DST>( from ) >= upper_bound_of<DST, SRC>() )
+        return ConversionError::Truncated;
+    SAFE_ANY_CHECK( (checkTruncation<SRC,DST>(from)) );
     target = static_cast<DST>( from);
+    return ConversionError::Ok;
 }
 
-} //end namespace details
+#undef SAFE_ANY_CHECK
 
+//----------------------- Dispatch on conversionKind() ---------------------------
 
-template<typename DST> inline
-DST Any::convert() const
+template <ConversionKind Kind>
+using ConversionKindTag = std::integral_constant<ConversionKind, Kind>;
+
+template<typename SRC,typename DST> inline
+ConversionError convert_number( const SRC& from, DST& target, ConversionKindTag<ConversionKind::Identity> )
 {
-    using details::convert_impl;
-    DST out;
+    target = from;
+    return ConversionError::Ok;
+}
+
+// no check and no branch
+template<typename SRC,typename DST> inline
+ConversionError convert_number( const SRC& from, DST& target, ConversionKindTag<ConversionKind::Widening> )
+{
+    target = static_cast<DST>( from );
+    return ConversionError::Ok;
+}
 
-    const auto& type = _any.type();
+template<typename SRC,typename DST> inline
+ConversionError convert_number( const SRC& from, DST& target, ConversionKindTag<ConversionKind::CheckedNarrowing> )
+{
+    typename canonical_number<DST>::type out;
+    const ConversionError error = convert_impl( from, out );
+    if( error == ConversionError::Ok ) { target = static_cast<DST>( out ); }
+    return error;
+}
 
-    if( ! details::is_convertible_type<DST>::value )
+template<typename SRC,typename DST> inline
+ConversionError convert_number( const SRC&, DST&, ConversionKindTag<ConversionKind::Impossible> )
+{
+    return ConversionError::NotConvertible;
+}
+
+template<typename SRC,typename DST> inline
+ConversionError convert_number( const SRC& from, DST& target )
+{
+    return convert_number( from, target, ConversionKindTag< conversionKind<SRC, DST>() >() );
+}
+
+
+//----------------------- Batches of convertRange() ------------------------------
+// Branch-free versions of convert_number(): the result is always written and
+// the function returns whether it is valid. SRC and DST are canonical numbers.
+
+template <typename T> inline
+typename std::enable_if< std::is_signed<T>::value, bool>::type
+is_negative( T value ) { return value < T(0); }
+
+template <typename T> inline
+typename std::enable_if< !std::is_signed<T>::value, bool>::type
+is_negative( T ) { return false; }
+
+template<typename SRC,typename DST> inline
+bool batch_convert( SRC from, DST& to, ConversionKindTag<ConversionKind::Identity> )
+{
+    to = from;
+    return true;
+}
+
+template<typename SRC,typename DST> inline
+bool batch_convert( SRC from, DST& to, ConversionKindTag<ConversionKind::Widening> )
+{
+    to = static_cast<DST>( from );
+    return true;
+}
+
+template<typename SRC,typename DST> inline
+bool batch_convert( SRC, DST& to, ConversionKindTag<ConversionKind::Impossible> )
+{
+    // written anyway, like the other kinds: convert_batch() always fills to[]
+    to = DST();
+    return false;
+}
+
+// integer to integer: the value must survive the round trip, sign included
+template<typename SRC,typename DST> inline
+typename std::enable_if< std::is_integral<SRC>::value && std::is_integral<DST>::value, bool>::type
+batch_convert_checked( SRC from, DST& to )
+{
+    to = static_cast<DST>( from );
+    return (static_cast<SRC>(to) == from) & (is_negative(to) == is_negative(from));
+}
+
+// integer to floating point: checkTruncation()
+template<typename SRC,typename DST> inline
+typename std::enable_if< std::is_integral<SRC>::value && std::is_floating_point<DST>::value, bool>::type
+batch_convert_checked( SRC from, DST& to )
+{
+    to = static_cast<DST>( from );
+    // 2^digits of SRC can't be converted back
+    const bool in_range = to < upper_bound_of<DST, SRC>();
+    return in_range & (static_cast<SRC>( in_range ? to : DST(0) ) == from);
+}
+
+// floating point to integer: range check first, the cast of a value out of range is undefined
+template<typename SRC,typename DST> inline
+typename std::enable_if< std::is_floating_point<SRC>::value && std::is_integral<DST>::value, bool>::type
+batch_convert_checked( SRC from, DST& to )
+{
+    const SRC lower = std::is_signed<DST>::value ? -upper_bound_of<SRC, DST>() : SRC(0);
+    const bool in_range = (from >= lower) & (from < upper_bound_of<SRC, DST>());
+    to = static_cast<DST>( in_range ? from : SRC(0) );
+    return in_range & (static_cast<SRC>(to) == from);
+}
+
+// floating point to floating point: checkTruncation()
+template<typename SRC,typename DST> inline
+typename std::enable_if< std::is_floating_point<SRC>::value && std::is_floating_point<DST>::value, bool>::type
+batch_convert_checked( SRC from, DST& to )
+{
+    to = static_cast<DST>( from );
+    return static_cast<SRC>(to) == from;
+}
+
+template<typename SRC,typename DST> inline
+bool batch_convert( SRC from, DST& to, ConversionKindTag<ConversionKind::CheckedNarrowing> )
+{
+    return batch_convert_checked( from, to );
+}
+
+template<typename SRC,typename DST> inline
+void convert_batch( const SRC* from, DST* to, uint8_t* valid, std::size_t count )
+{
+    typedef ConversionKindTag< conversionKind<SRC, DST>() > Kind;
+    for(std::size_t i=0; i<count; i++)
     {
-        return linb::any_cast<DST>(_any);
+        valid[i] = batch_convert( from[i], to[i], Kind() );
     }
+}
 
-    if( type == typeid(bool)) {
-        return DST( extract<bool>() );
+struct range_access
+{
+    // T must be the stored type.
+    template <typename T> static const T& value(const Any& any)
+    {
+        return any._is_number ? any._number.unchecked<T>() : any._any.unchecked_cast<T>();
     }
-    else if( type == typeid(char)) {
-        convert_impl<int8_t,  DST>( int8_t(extract<char>()), out  );
+};
+
+// Converts first[0], ... first[count-1] (count <= 256), if they all have the type
+// Stored (with the given id); otherwise returns std::size_t(-1) and does nothing.
+// Usual case: one pass to check the types and gather the values, no index.
+template<typename Stored, typename DST> inline
+std::size_t convert_uniform( const Any* first, std::size_t count, uint32_t id, DST* out,
+                             std::vector<std::size_t>* failed, std::size_t offset )
+{
+    typedef typename canonical_number<Stored>::type SRC;
+    typedef typename canonical_number<DST>::type Result;
+    const std::size_t CHUNK = 256;
+
+    SRC from[CHUNK];
+    Result to[CHUNK];
+    uint8_t valid[CHUNK];
+
+    for(std::size_t i=0; i<count; i++)
+    {
+        if( first[i].typeId() != id ) { return std::size_t(-1); }
+        from[i] = static_cast<SRC>( range_access::value<Stored>( first[i] ) );
     }
-    else if( type == typeid(int8_t)) {
-        convert_impl<int8_t,  DST>(extract<int8_t>(), out  );
+    convert_batch( from, to, valid, count );
+
+    std::size_t valid_count = 0;
+    for(std::size_t i=0; i<count; i++)
+    {
+        if( valid[i] ) { out[i] = static_cast<DST>( to[i] ); }
+        valid_count += valid[i];
     }
-    else if( type == typeid(int16_t)) {
-        convert_impl<int16_t,  DST>(extract<int16_t>(), out  );
+    if( failed && valid_count < count )
+    {
+        for(std::size_t i=0; i<count; i++) {
+            if( !valid[i] ) { failed->push_back( offset + i ); }
+        }
     }
-    else if( type == typeid(int32_t)) {
-        convert_impl<int32_t,  DST>(extract<int32_t>(), out  );
+    return count - valid_count;
+}
+
+// Converts the values first[index[0]], ... first[index[count-1]], all of type
+// Stored, into out: gather, convert_batch(), scatter.
+template<typename Stored, typename DST> inline
+std::size_t convert_group( const Any* first, const uint32_t* index, std::size_t count, DST* out,
+                           std::vector<std::size_t>* failed, std::size_t offset )
+{
+    typedef typename canonical_number<Stored>::type SRC;
+    typedef typename canonical_number<DST>::type Result;
+    const std::size_t CHUNK = 256;
+
+    SRC from[CHUNK];
+    Result to[CHUNK];
+    uint8_t valid[CHUNK];
+    std::size_t failures = 0;
+
+    for(std::size_t k=0; k<count; k++) {
+        from[k] = static_cast<SRC>( range_access::value<Stored>( first[index[k]] ) );
     }
-    else if( type == typeid(int64_t)) {
-        convert_impl<int64_t,  DST>(extract<int64_t>(), out  );
+    convert_batch( from, to, valid, count );
+    for(std::size_t k=0; k<count; k++)
+    {
+        if( valid[k] ) {
+            out[ index[k] ] = static_cast<DST>( to[k] );
+        }
+        else {
+            failures++;
+            if( failed ) { failed->push_back( offset + index[k] ); }
+        }
     }
-    else if( type == typeid(uint8_t)) {
-        convert_impl<uint8_t,  DST>(extract<uint8_t>(), out  );
+    return failures;
+}
+
+
+//----------------------- Vectors of numbers ----------------------------------------
+
+// True if every element of from[0, count) can be converted to DST.
+template<typename SRC,typename DST> inline
+bool batch_valid( const SRC*, std::size_t, ConversionKindTag<ConversionKind::Identity> ) { return true; }
+
+template<typename SRC,typename DST> inline
+bool batch_valid( const SRC*, std::size_t, ConversionKindTag<ConversionKind::Widening> ) { return true; }
+
+template<typename SRC,typename DST> inline
+bool batch_valid( const SRC*, std::size_t count, ConversionKindTag<ConversionKind::Impossible> ) { return count == 0; }
+
+// integer to integer: the values that fit are an interval, only the minimum
+// and the maximum are checked
+template<typename SRC,typename DST> inline
+typename std::enable_if< std::is_integral<SRC>::value && std::is_integral<DST>::value, bool>::type
+batch_valid_checked( const SRC* from, std::size_t count )
+{
+    SRC low = from[0];
+    SRC high = from[0];
+    for(std::size_t i=1; i<count; i++)
+    {
+        low  = std::min( low, from[i] );
+        high = std::max( high, from[i] );
+    }
+    DST out;
+    return batch_convert_checked( low, out ) & batch_convert_checked( high, out );
+}
+
+// the others need the round trip of every element
+template<typename SRC,typename DST> inline
+typename std::enable_if< !(std::is_integral<SRC>::value && std::is_integral<DST>::value), bool>::type
+batch_valid_checked( const SRC* from, std::size_t count )
+{
+    uint8_t valid = 1;
+    for(std::size_t i=0; i<count; i++)
+    {
+        DST out;
+        valid &= static_cast<uint8_t>( batch_convert_checked( from[i], out ) );
     }
-    else if( type == typeid(uint16_t)) {
-        convert_impl<uint16_t,  DST>(extract<uint16_t>(), out  );
+    return valid != 0;
+}
+
+template<typename SRC,typename DST> inline
+bool batch_valid( const SRC* from, std::size_t count, ConversionKindTag<ConversionKind::CheckedNarrowing> )
+{
+    return count == 0 || batch_valid_checked<SRC, DST>( from, count );
+}
+
+// Checks all the elements first, then converts them: "to" is not modified if it fails.
+template<typename SRC,typename DST> inline
+ConversionError convert_vector( const std::vector<SRC>& from, std::vector<DST>& to )
+{
+    const std::size_t count = from.size();
+    if( !batch_valid<SRC, DST>( from.data(), count, ConversionKindTag< conversionKind<SRC, DST>() >() ) )
+    {
+        // the error of the first element that fails
+        for(std::size_t i=0; i<count; i++)
+        {
+            DST out;
+            const ConversionError error = convert_number( from[i], out );
+            if( error != ConversionError::Ok ) { return error; }
+        }
+    }
+    to.resize( count );
+    const SRC* src = from.data();
+    DST* dst = to.data();
+    for(std::size_t i=0; i<count; i++)
+    {
+        dst[i] = static_cast<DST>( src[i] );
+    }
+    return ConversionError::Ok;
+}
+
+} //end namespace details
+
+
+//----------------------- Parsing ----------------------------------------------
+
+namespace details{
+
+// The text denotes a number exactly: an integer gets the checks of convert_number(),
+// a floating point number the nearest value (a cast is correctly rounded).
+template <typename SRC, typename DST> inline
+ConversionError convert_parsed_integer( SRC from, DST& to )
+{
+    return convert_number( from, to );
+}
+
+template <typename SRC> inline
+ConversionError convert_parsed_integer( SRC from, float& to )
+{
+    to = static_cast<float>( from );
+    return ConversionError::Ok;
+}
+
+template <typename SRC> inline
+ConversionError convert_parsed_integer( SRC from, double& to )
+{
+    to = static_cast<double>( from );
+    return ConversionError::Ok;
+}
+
+template <typename DST> inline
+ConversionError convert_parsed_floating( double from, DST& to )
+{
+    return convert_number( from, to );
+}
+
+inline ConversionError convert_parsed_floating( double from, float& to )
+{
+    if( from > std::numeric_limits<float>::max() && from != std::numeric_limits<double>::infinity() ) {
+        return ConversionError::TooLarge;
     }
-    else if( type == typeid(uint32_t)) {
-        convert_impl<uint32_t,  DST>(extract<uint32_t>(), out  );
+    if( from < -std::numeric_limits<float>::max() && from != -std::numeric_limits<double>::infinity() ) {
+        return ConversionError::TooSmall;
     }
-    else if( type == typeid(uint64_t)) {
-        convert_impl<uint64_t,  DST>(extract<uint64_t>(), out  );
+    to = static_cast<float>( from );
+    return ConversionError::Ok;
+}
+
+template <typename DST> inline
+ConversionError convert_parsed( const ParsedNumber& number, DST& to )
+{
+    switch( number.kind )
+    {
+    case ParsedNumber::UNSIGNED:     return convert_parsed_integer( number.u, to );
+    case ParsedNumber::SIGNED:       return convert_parsed_integer( number.i, to );
+    case ParsedNumber::FLOATING:     return convert_parsed_floating( number.d, to );
+    case ParsedNumber::OUT_OF_RANGE: return number.d > 0 ? ConversionError::TooLarge : ConversionError::TooSmall;
+    case ParsedNumber::BOOLEAN:      return ConversionError::NotConvertible;
+    default:                         return ConversionError::InvalidNumber;
     }
-    else if( type == typeid(float)) {
-        convert_impl<float,  DST>(extract<float>(), out  );
+}
+
+// "true", "false", "1" and "0" only.
+inline ConversionError convert_parsed( const ParsedNumber& number, bool& to )
+{
+    if( number.kind == ParsedNumber::INVALID ) { return ConversionError::InvalidNumber; }
+    if( (number.kind != ParsedNumber::BOOLEAN && number.kind != ParsedNumber::UNSIGNED) || number.u > 1 ) {
+        return ConversionError::NotConvertible;
     }
-    else if( type == typeid(double)) {
-        convert_impl<double,  DST>(extract<double>(), out  );
+    to = ( number.u == 1 );
+    return ConversionError::Ok;
+}
+
+} //end namespace details
+
+// Locale-independent and allocation-free conversion of the text [first, last) to a number:
+// [+-]digits[.digits][(e|E)[+-]digits], "inf" and "nan" with an optional sign; "true",
+// "false", "1" and "0" for bool. The whole text must be a number (no spaces).
+// An integer destination has the range checks of Any::convert(), as if the number was
+// stored as an integer (no decimal point nor exponent) or as a double: "300" can't be
+// an uint8_t, "2.5" can't be an int, but "1e3" can. A float or a double gets the value
+// nearest to the text, as strtod() does.
+template <typename T> inline
+ConversionError parseNumber(const char* first, const char* last, T& value)
+{
+    static_assert( std::is_arithmetic<T>::value, "parseNumber() requires a number" );
+    return details::convert_parsed( details::parse_number( first, last ), value );
+}
+
+template<typename T> inline
+ConversionError Any::tryParse(T& dst) const
+{
+    return tryParseImpl( dst, std::is_arithmetic<T>() );
+}
+
+template<typename T> inline
+ConversionError Any::tryParseImpl(T& dst, std::true_type) const
+{
+    if( const SimpleString* str = extractPtr<SimpleString>() )
+    {
+        return details::convert_parsed( str->parsedNumber(), dst );
     }
-    else if( type == typeid(SimpleString) )
+    return tryConvert( dst );
+}
+
+template<typename DST> inline
+DST Any::convert() const
+{
+    return convertImpl<DST>( std::integral_constant<bool, details::is_convertible_type<DST>::value
+                                                          || details::is_number_vector<DST>::value>() );
+}
+
+template<typename DST> inline
+ConversionError NumberAny::tryConvert(DST& dst) const
+{
+    using details::convert_number;
+
+    if( ! details::is_convertible_type<DST>::value )
     {
-        throw std::runtime_error("String can not be converted to another type implicitly");
+        return ConversionError::TypeMismatch;
     }
-    else{
-        return linb::any_cast<DST>(_any);
+    switch( _tag )
+    {
+    case TR::id_bool:   return convert_number( _payload.b, dst );
+    case TR::id_char:   return convert_number( int8_t(_payload.c), dst );
+    case TR::id_int8:   return convert_number( _payload.i8, dst );
+    case TR::id_int16:  return convert_number( _payload.i16, dst );
+    case TR::id_int32:  return convert_number( _payload.i32, dst );
+    case TR::id_int64:  return convert_number( _payload.i64, dst );
+    case TR::id_uint8:  return convert_number( _payload.u8, dst );
+    case TR::id_uint16: return convert_number( _payload.u16, dst );
+    case TR::id_uint32: return convert_number( _payload.u32, dst );
+    case TR::id_uint64: return convert_number( _payload.u64, dst );
+    case TR::id_float:  return convert_number( _payload.f, dst );
+    case TR::id_double: return convert_number( _payload.d, dst );
+    default:            return ConversionError::TypeMismatch;
     }
+}
 
+template<typename DST> inline
+DST NumberAny::convert() const
+{
+    DST out;
+    const ConversionError error = tryConvert(out);
+    if( error != ConversionError::Ok ) { details::throwConversionError(error); }
     return out;
 }
 
-template<> inline std::string Any::convert() const
+template<typename DST> inline
+ConversionError Any::tryConvert(DST& dst) const
 {
-    const auto& type = _any.type();
+    using details::convert_number;
+    typedef linb::detail::type_registry TR;
 
-    if( type == typeid(SimpleString) )
+    if( const DST* ptr = extractPtr<DST>() )
     {
-        return extract<SimpleString>().toStdString();
-    }
-    else if( type == typeid(bool)) {
-        return std::to_string( extract<bool>() );
+        dst = *ptr;
+        return ConversionError::Ok;
     }
-    else if( type == typeid(char)) {
-        return std::to_string( extract<char>() );
+    if( ! details::is_convertible_type<DST>::value )
+    {
+        return tryConvertVector( dst, details::is_number_vector<DST>() );
     }
-    else if( type == typeid(int8_t)) {
-        return std::to_string( extract<int8_t>() );
+    if( _is_number )
+    {
+        return _number.tryConvert( dst );
     }
-    else if( type == typeid(int16_t)) {
-        return std::to_string( extract<int16_t>() );
+
+    // numbers stored by makeShared().
+    // The ids of the arithmetic types are fixed: no std::type_info comparison
+    switch( _any.type_id() )
+    {
+    case TR::id_bool:
+        return convert_number( extract<bool>(), dst );
+    case TR::id_char:
+        return convert_number( int8_t(extract<char>()), dst );
+    case TR::id_int8:
+        return convert_number( extract<int8_t>(), dst );
+    case TR::id_int16:
+        return convert_number( extract<int16_t>(), dst );
+    case TR::id_int32:
+        return convert_number( extract<int32_t>(), dst );
+    case TR::id_int64:
+        return convert_number( extract<int64_t>(), dst );
+    case TR::id_uint8:
+        return convert_number( extract<uint8_t>(), dst );
+    case TR::id_uint16:
+        return convert_number( extract<uint16_t>(), dst );
+    case TR::id_uint32:
+        return convert_number( extract<uint32_t>(), dst );
+    case TR::id_uint64:
+        return convert_number( extract<uint64_t>(), dst );
+    case TR::id_float:
+        return convert_number( extract<float>(), dst );
+    case TR::id_double:
+        return convert_number( extract<double>(), dst );
+    default:
+        break;
     }
-    else if( type == typeid(int32_t)) {
-        return std::to_string( extract<int32_t>() );
+
+    if( extractPtr<SimpleString>() )
+    {
+        return ConversionError::StringToNumber;
     }
-    else if( type == typeid(int64_t)) {
-        return std::to_string( extract<int64_t>() );
+    return ConversionError::TypeMismatch;
+}
+
+template<typename T> inline
+ConversionError Any::tryConvertVector(std::vector<T>& dst, std::true_type) const
+{
+#define SAFE_ANY_CONVERT_VECTOR(TYPE) \
+    if( const std::vector<TYPE>* ptr = extractPtr<std::vector<TYPE>>() ) { return details::convert_vector( *ptr, dst ); }
+
+    SAFE_ANY_CONVERT_VECTOR( double )
+    SAFE_ANY_CONVERT_VECTOR( float )
+    SAFE_ANY_CONVERT_VECTOR( int32_t )
+    SAFE_ANY_CONVERT_VECTOR( int64_t )
+    SAFE_ANY_CONVERT_VECTOR( uint8_t )
+    SAFE_ANY_CONVERT_VECTOR( uint16_t )
+    SAFE_ANY_CONVERT_VECTOR( uint32_t )
+    SAFE_ANY_CONVERT_VECTOR( uint64_t )
+    SAFE_ANY_CONVERT_VECTOR( int8_t )
+    SAFE_ANY_CONVERT_VECTOR( int16_t )
+
+#undef SAFE_ANY_CONVERT_VECTOR
+    return ConversionError::TypeMismatch;
+}
+
+namespace details{
+
+template <typename T> inline
+void assign_number( std::string& dst, T value )
+{
+    char buffer[NUMBER_BUFFER_SIZE];
+    dst.assign( buffer, formatNumber( buffer, value ) );
+}
+
+} //end namespace details
+
+// Numbers are written by formatNumber(): the floating point ones with the
+// shortest text that is parsed back to the same value.
+template<> inline ConversionError NumberAny::tryConvert(std::string& dst) const
+{
+    switch( _tag )
+    {
+    case TR::id_bool:   details::assign_number( dst, _payload.b ); break;
+    case TR::id_char:   details::assign_number( dst, _payload.c ); break;
+    case TR::id_int8:   details::assign_number( dst, _payload.i8 ); break;
+    case TR::id_int16:  details::assign_number( dst, _payload.i16 ); break;
+    case TR::id_int32:  details::assign_number( dst, _payload.i32 ); break;
+    case TR::id_int64:  details::assign_number( dst, _payload.i64 ); break;
+    case TR::id_uint8:  details::assign_number( dst, _payload.u8 ); break;
+    case TR::id_uint16: details::assign_number( dst, _payload.u16 ); break;
+    case TR::id_uint32: details::assign_number( dst, _payload.u32 ); break;
+    case TR::id_uint64: details::assign_number( dst, _payload.u64 ); break;
+    case TR::id_float:  details::assign_number( dst, _payload.f ); break;
+    case TR::id_double: details::assign_number( dst, _payload.d ); break;
+    default:            return ConversionError::NotAString;
     }
-    else if( type == typeid(uint8_t)) {
-        return std::to_string( extract<uint8_t>() );
+    return ConversionError::Ok;
+}
+
+template<> inline ConversionError Any::tryConvert(std::string& dst) const
+{
+    typedef linb::detail::type_registry TR;
+
+    if( _is_number )
+    {
+        return _number.tryConvert( dst );
     }
-    else if( type == typeid(uint16_t)) {
-        return std::to_string( extract<uint16_t>() );
+    if( const SimpleString* str = extractPtr<SimpleString>() )
+    {
+        dst.assign(str->data(), str->size());
+        return ConversionError::Ok;
     }
-    else if( type == typeid(uint32_t)) {
-        return std::to_string( extract<uint32_t>() );
+
+    // numbers stored by makeShared()
+    switch( typeId() )
+    {
+    case TR::id_bool:   details::assign_number( dst, extract<bool>() ); break;
+    case TR::id_char:   details::assign_number( dst, extract<char>() ); break;
+    case TR::id_int8:   details::assign_number( dst, extract<int8_t>() ); break;
+    case TR::id_int16:  details::assign_number( dst, extract<int16_t>() ); break;
+    case TR::id_int32:  details::assign_number( dst, extract<int32_t>() ); break;
+    case TR::id_int64:  details::assign_number( dst, extract<int64_t>() ); break;
+    case TR::id_uint8:  details::assign_number( dst, extract<uint8_t>() ); break;
+    case TR::id_uint16: details::assign_number( dst, extract<uint16_t>() ); break;
+    case TR::id_uint32: details::assign_number( dst, extract<uint32_t>() ); break;
+    case TR::id_uint64: details::assign_number( dst, extract<uint64_t>() ); break;
+    case TR::id_float:  details::assign_number( dst, extract<float>() ); break;
+    case TR::id_double: details::assign_number( dst, extract<double>() ); break;
+    default:            return ConversionError::NotAString;
     }
-    else if( type == typeid(uint64_t)) {
-        return std::to_string( extract<uint64_t>() );
+    return ConversionError::Ok;
+}
+
+
+namespace details{
+
+// DST is not a number: one value at a time.
+template <typename DST> inline
+std::size_t convert_range( const Any* first, std::size_t count, DST* out,
+                           std::vector<std::size_t>* failed, std::false_type )
+{
+    std::size_t failures = 0;
+    for(std::size_t i=0; i<count; i++)
+    {
+        if( first[i].tryConvert( out[i] ) != ConversionError::Ok )
+        {
+            failures++;
+            if( failed ) { failed->push_back(i); }
+        }
     }
-    else if( type == typeid(float)) {
-        return std::to_string( extract<float>() );
+    return failures;
+}
+
+template <typename DST> inline
+std::size_t convert_range( const Any* first, std::size_t count, DST* out,
+                           std::vector<std::size_t>* failed, std::true_type )
+{
+    typedef linb::detail::type_registry TR;
+    const std::size_t BLOCK = 256;
+    const std::size_t failed_before = failed ? failed->size() : 0;
+    std::size_t failures = 0;
+
+    uint8_t tag[BLOCK];
+    uint32_t order[BLOCK];
+
+    for(std::size_t offset = 0; offset < count; offset += BLOCK)
+    {
+        const Any* block = first + offset;
+        const std::size_t size = std::min( BLOCK, count - offset );
+
+        std::size_t uniform = std::size_t(-1);
+        switch( block[0].typeId() )
+        {
+#define SAFE_ANY_CONVERT_UNIFORM(ID, TYPE) \
+        case TR::ID: uniform = convert_uniform<TYPE>( block, size, TR::ID, out + offset, failed, offset ); break;
+
+        SAFE_ANY_CONVERT_UNIFORM( id_bool,   bool )
+        SAFE_ANY_CONVERT_UNIFORM( id_char,   char )
+        SAFE_ANY_CONVERT_UNIFORM( id_int8,   int8_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_int16,  int16_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_int32,  int32_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_int64,  int64_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_uint8,  uint8_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_uint16, uint16_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_uint32, uint32_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_uint64, uint64_t )
+        SAFE_ANY_CONVERT_UNIFORM( id_float,  float )
+        SAFE_ANY_CONVERT_UNIFORM( id_double, double )
+
+#undef SAFE_ANY_CONVERT_UNIFORM
+        default: break;
+        }
+        if( uniform != std::size_t(-1) )
+        {
+            failures += uniform;
+            continue;
+        }
+
+        // mixed types: counting sort of the indexes by type; the values that
+        // are not numbers (tag first_user_id) are converted one by one
+        uint32_t begin[TR::first_user_id + 2] = {0};
+        for(std::size_t i=0; i<size; i++)
+        {
+            const uint32_t id = block[i].typeId();
+            tag[i] = static_cast<uint8_t>( (id != TR::id_void && id < TR::first_user_id) ? id : TR::first_user_id );
+            begin[ tag[i] + 1 ]++;
+        }
+        for(uint32_t t=1; t < TR::first_user_id + 2; t++) {
+            begin[t] += begin[t-1];
+        }
+        uint32_t end[TR::first_user_id + 1];
+        std::copy( begin, begin + TR::first_user_id + 1, end );
+        for(std::size_t i=0; i<size; i++) {
+            order[ end[ tag[i] ]++ ] = static_cast<uint32_t>(i);
+        }
+
+#define SAFE_ANY_CONVERT_GROUP(ID, TYPE) \
+        if( end[TR::ID] > begin[TR::ID] ) { \
+            failures += convert_group<TYPE>( block, order + begin[TR::ID], end[TR::ID] - begin[TR::ID], \
+                                             out + offset, failed, offset ); }
+
+        SAFE_ANY_CONVERT_GROUP( id_bool,   bool )
+        SAFE_ANY_CONVERT_GROUP( id_char,   char )
+        SAFE_ANY_CONVERT_GROUP( id_int8,   int8_t )
+        SAFE_ANY_CONVERT_GROUP( id_int16,  int16_t )
+        SAFE_ANY_CONVERT_GROUP( id_int32,  int32_t )
+        SAFE_ANY_CONVERT_GROUP( id_int64,  int64_t )
+        SAFE_ANY_CONVERT_GROUP( id_uint8,  uint8_t )
+        SAFE_ANY_CONVERT_GROUP( id_uint16, uint16_t )
+        SAFE_ANY_CONVERT_GROUP( id_uint32, uint32_t )
+        SAFE_ANY_CONVERT_GROUP( id_uint64, uint64_t )
+        SAFE_ANY_CONVERT_GROUP( id_float,  float )
+        SAFE_ANY_CONVERT_GROUP( id_double, double )
+
+#undef SAFE_ANY_CONVERT_GROUP
+
+        for(uint32_t k = begin[TR::first_user_id]; k < end[TR::first_user_id]; k++)
+        {
+            const uint32_t i = order[k];
+            if( block[i].tryConvert( out[offset + i] ) != ConversionError::Ok )
+            {
+                failures++;
+                if( failed ) { failed->push_back( offset + i ); }
+            }
+        }
     }
-    else if( type == typeid(double)) {
-        return std::to_string( extract<double>() );
+
+    if( failed ) {
+        std::sort( failed->begin() + failed_before, failed->end() );
     }
+    return failures;
+}
 
-    throw std::runtime_error("Conversion to std::string failed");
+} // end namespace details
+
+template <typename DST> inline
+std::size_t convertRange(const Any* first, const Any* last, DST* out,
+                         std::vector<std::size_t>* failed)
+{
+    return details::convert_range( first, static_cast<std::size_t>(last - first), out, failed,
+                                   std::is_arithmetic<DST>() );
 }
 
+// Last successful conversion of a value to a number, memoized by the owner of the
+// value (e.g. an entry of BlackboardLocal), which must call clear() whenever the value
+// changes. Reading the value again as the same type is a compare and a load.
+// Not thread-safe.
+class ConversionCache
+{
+public:
+    ConversionCache(): _type(0), _bits(0) {}
+
+    void clear() { _type = 0; }
+
+    // Same as value.tryConvert(dst), memoized if T is one of the builtin numbers
+    // (not e.g. long double, larger than the cache).
+    template <typename T> ConversionError convert(const Any& value, T& dst)
+    {
+        return convertImpl( value, dst, details::is_tagged_number<T>() );
+    }
+
+private:
+    template <typename T> ConversionError convertImpl(const Any& value, T& dst, std::false_type)
+    {
+        return value.tryConvert( dst );
+    }
+
+    template <typename T> ConversionError convertImpl(const Any& value, T& dst, std::true_type)
+    {
+        static_assert( sizeof(T) <= sizeof(uint64_t), "the cached number must fit into _bits" );
+        const uint32_t type = linb::detail::type_id<T>();
+        if( _type == type )
+        {
+            std::memcpy( &dst, &_bits, sizeof(T) );
+            return ConversionError::Ok;
+        }
+        const ConversionError error = value.tryConvert( dst );
+        if( error == ConversionError::Ok )
+        {
+            std::memcpy( &_bits, &dst, sizeof(T) );
+            _type = type;
+        }
+        return error;
+    }
+
+    uint32_t _type;   // linb::detail::type_id() of the cached number, 0 if empty
+    uint64_t _bits;
+};
 
 } // end namespace VarNumber
 
@@ -0,0 +1,229 @@
+#ifndef SAFE_ANY_TYPE_TAG_H
+#define SAFE_ANY_TYPE_TAG_H
+
+#include <cstring>
+#include <string>
+#include "safe_any.hpp"
+
+namespace SafeAny{
+
+// Small integer identifying the types that have a fixed, address-independent layout.
+// Backends that serialize values or store them outside the process memory
+// (shared memory, files, databases) use it instead of std::type_info.
+enum class TypeTag : uint8_t
+{
+    EMPTY = 0, BOOL, CHAR, INT8, INT16, INT32, INT64,
+    UINT8, UINT16, UINT32, UINT64, FLOAT, DOUBLE, STRING,
+    OTHER
+};
+
+inline TypeTag getTypeTag(const std::type_info& type)
+{
+    if( type == typeid(bool) )          return TypeTag::BOOL;
+    else if( type == typeid(char) )     return TypeTag::CHAR;
+    else if( type == typeid(int8_t) )   return TypeTag::INT8;
+    else if( type == typeid(int16_t) )  return TypeTag::INT16;
+    else if( type == typeid(int32_t) )  return TypeTag::INT32;
+    else if( type == typeid(int64_t) )  return TypeTag::INT64;
+    else if( type == typeid(uint8_t) )  return TypeTag::UINT8;
+    else if( type == typeid(uint16_t) ) return TypeTag::UINT16;
+    else if( type == typeid(uint32_t) ) return TypeTag::UINT32;
+    else if( type == typeid(uint64_t) ) return TypeTag::UINT64;
+    else if( type == typeid(float) )    return TypeTag::FLOAT;
+    else if( type == typeid(double) )   return TypeTag::DOUBLE;
+    else if( type == typeid(SimpleString) ) return TypeTag::STRING;
+    else if( type == typeid(void) )     return TypeTag::EMPTY;
+    return TypeTag::OTHER;
+}
+
+// Same result of getTypeTag(value.type()), without comparing std::type_info:
+// the tags of the numbers are equal to the ids of linb::detail::type_registry.
+inline TypeTag getTypeTag(const Any& value)
+{
+    static_assert( uint32_t(TypeTag::DOUBLE) == linb::detail::type_registry::id_double &&
+                   uint32_t(TypeTag::STRING) == linb::detail::type_registry::first_user_id,
+                   "TypeTag and type_registry::builtin_id must be aligned");
+
+    const uint32_t id = value.typeId();
+    if( id < linb::detail::type_registry::first_user_id ){
+        return static_cast<TypeTag>(id);
+    }
+    return value.extractPtr<SimpleString>() ? TypeTag::STRING : TypeTag::OTHER;
+}
+
+inline bool isNumber(TypeTag tag)
+{
+    return tag >= TypeTag::BOOL && tag <= TypeTag::DOUBLE;
+}
+
+namespace details{
+
+template <typename T> inline uint64_t toBits(const T& value)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+template <typename T> inline T fromBits(uint64_t bits)
+{
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+inline void appendVarint(std::size_t value, std::string& out)
+{
+    do{
+        out.push_back( static_cast<char>( (value & 0x7F) | (value > 0x7F ? 0x80 : 0) ) );
+        value >>= 7;
+    } while( value > 0 );
+}
+
+inline bool readVarint(const char*& ptr, const char* end, std::size_t& value)
+{
+    value = 0;
+    for (int shift = 0; ptr < end && shift <= 56; shift += 7)
+    {
+        const uint8_t byte = static_cast<uint8_t>(*ptr++);
+        value |= std::size_t(byte & 0x7F) << shift;
+        if( (byte & 0x80) == 0 ) { return true; }
+    }
+    return false;
+}
+
+} // end namespace details
+
+// Raw bits of the number stored in value. Throws if the tag is not a number.
+inline uint64_t numberToBits(const Any& value, TypeTag tag)
+{
+    using details::toBits;
+    switch( tag )
+    {
+    case TypeTag::BOOL:   return toBits( value.extract<bool>() );
+    case TypeTag::CHAR:   return toBits( value.extract<char>() );
+    case TypeTag::INT8:   return toBits( value.extract<int8_t>() );
+    case TypeTag::INT16:  return toBits( value.extract<int16_t>() );
+    case TypeTag::INT32:  return toBits( value.extract<int32_t>() );
+    case TypeTag::INT64:  return toBits( value.extract<int64_t>() );
+    case TypeTag::UINT8:  return toBits( value.extract<uint8_t>() );
+    case TypeTag::UINT16: return toBits( value.extract<uint16_t>() );
+    case TypeTag::UINT32: return toBits( value.extract<uint32_t>() );
+    case TypeTag::UINT64: return toBits( value.extract<uint64_t>() );
+    case TypeTag::FLOAT:  return toBits( value.extract<float>() );
+    case TypeTag::DOUBLE: return toBits( value.extract<double>() );
+    default: break;
+    }
+    throw std::runtime_error("numberToBits: not a number");
+}
+
+// Inverse of numberToBits(). Throws if the tag is not a number.
+inline Any numberFromBits(TypeTag tag, uint64_t bits)
+{
+    using details::fromBits;
+    switch( tag )
+    {
+    case TypeTag::BOOL:   return Any( fromBits<bool>(bits) );
+    case TypeTag::CHAR:   return Any( fromBits<char>(bits) );
+    case TypeTag::INT8:   return Any( fromBits<int8_t>(bits) );
+    case TypeTag::INT16:  return Any( fromBits<int16_t>(bits) );
+    case TypeTag::INT32:  return Any( fromBits<int32_t>(bits) );
+    case TypeTag::INT64:  return Any( fromBits<int64_t>(bits) );
+    case TypeTag::UINT8:  return Any( fromBits<uint8_t>(bits) );
+    case TypeTag::UINT16: return Any( fromBits<uint16_t>(bits) );
+    case TypeTag::UINT32: return Any( fromBits<uint32_t>(bits) );
+    case TypeTag::UINT64: return Any( fromBits<uint64_t>(bits) );
+    case TypeTag::FLOAT:  return Any( fromBits<float>(bits) );
+    case TypeTag::DOUBLE: return Any( fromBits<double>(bits) );
+    default: break;
+    }
+    throw std::runtime_error("numberFromBits: not a number");
+}
+
+// Size in bytes of a number with the given tag, 0 if it is not a number.
+inline std::size_t numberSize(TypeTag tag)
+{
+    switch( tag )
+    {
+    case TypeTag::BOOL:
+    case TypeTag::CHAR:
+    case TypeTag::INT8:
+    case TypeTag::UINT8:  return 1;
+    case TypeTag::INT16:
+    case TypeTag::UINT16: return 2;
+    case TypeTag::INT32:
+    case TypeTag::UINT32:
+    case TypeTag::FLOAT:  return 4;
+    case TypeTag::INT64:
+    case TypeTag::UINT64:
+    case TypeTag::DOUBLE: return 8;
+    default: break;
+    }
+    return 0;
+}
+
+// Compact binary encoding of a value, appended to "out":
+//
+//  - numbers: the tag followed by the bytes of the number (1 to 8).
+//  - strings: the tag, the size as a varint and the characters.
+//
+// Only numbers and strings can be encoded; throws otherwise.
+inline void encodeValue(const Any& value, std::string& out)
+{
+    const TypeTag tag = getTypeTag( value );
+    out.push_back( static_cast<char>(tag) );
+
+    if( isNumber(tag) )
+    {
+        const uint64_t bits = numberToBits(value, tag);
+        out.append( reinterpret_cast<const char*>(&bits), numberSize(tag) );
+    }
+    else if( tag == TypeTag::STRING )
+    {
+        const SimpleString& str = *value.extractPtr<SimpleString>();
+        details::appendVarint( str.size(), out );
+        out.append( str.data(), str.size() );
+    }
+    else{
+        out.pop_back();
+        throw std::runtime_error("encodeValue: only numbers and strings can be encoded");
+    }
+}
+
+// Decode a value written by encodeValue(), starting from "ptr".
+// On success, advances ptr after the value and returns true.
+inline bool decodeValue(const char*& ptr, const char* end, Any& value)
+{
+    if( ptr >= end ) { return false; }
+
+    const char* p = ptr;
+    const TypeTag tag = static_cast<TypeTag>(*p++);
+
+    if( isNumber(tag) )
+    {
+        const std::size_t size = numberSize(tag);
+        if( static_cast<std::size_t>(end - p) < size ) { return false; }
+        uint64_t bits = 0;
+        memcpy( &bits, p, size );
+        value = numberFromBits(tag, bits);
+        ptr = p + size;
+        return true;
+    }
+    else if( tag == TypeTag::STRING )
+    {
+        std::size_t size = 0;
+        if( !details::readVarint(p, end, size) ||
+            static_cast<std::size_t>(end - p) < size )
+        {
+            return false;
+        }
+        value = Any( SimpleString(p, size) );
+        ptr = p + size;
+        return true;
+    }
+    return false;
+}
+
+} // end namespace SafeAny
+
+#endif // SAFE_ANY_TYPE_TAG_H
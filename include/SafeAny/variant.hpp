@@ -0,0 +1,346 @@
+#ifndef SAFE_ANY_VARIANT_H
+#define SAFE_ANY_VARIANT_H
+
+#include <new>
+#include <tuple>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include "safe_any.hpp"
+
+namespace SafeAny{
+
+namespace details{
+
+// Position of T in Types..., sizeof...(Types) if it is not one of them.
+template <typename T, typename... Types> struct index_of;
+
+template <typename T> struct index_of<T> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename... Rest>
+struct index_of<T, T, Rest...> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename First, typename... Rest>
+struct index_of<T, First, Rest...> : std::integral_constant<std::size_t, 1 + index_of<T, Rest...>::value> {};
+
+// How convert_value() converts a SRC to a DST.
+enum class ValueConversion { Identity, Number, NumberToString, NumberVector, StringToNumber, NotAString, Mismatch };
+
+template <typename SRC, typename DST>
+struct value_conversion : std::integral_constant<ValueConversion,
+        std::is_same<SRC, DST>::value ? ValueConversion::Identity :
+        std::is_arithmetic<SRC>::value && std::is_arithmetic<DST>::value ? ValueConversion::Number :
+        std::is_arithmetic<SRC>::value && std::is_same<DST, std::string>::value ? ValueConversion::NumberToString :
+        is_number_vector<SRC>::value && is_number_vector<DST>::value ? ValueConversion::NumberVector :
+        std::is_same<SRC, std::string>::value && std::is_arithmetic<DST>::value ? ValueConversion::StringToNumber :
+        std::is_same<DST, std::string>::value ? ValueConversion::NotAString :
+        ValueConversion::Mismatch >
+{};
+
+template <ValueConversion Kind>
+using ValueConversionTag = std::integral_constant<ValueConversion, Kind>;
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC& from, DST& to, ValueConversionTag<ValueConversion::Identity> )
+{
+    to = from;
+    return ConversionError::Ok;
+}
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC& from, DST& to, ValueConversionTag<ValueConversion::Number> )
+{
+    return convert_number( static_cast<typename canonical_number<SRC>::type>(from), to );
+}
+
+template <typename SRC> inline
+ConversionError convert_value( const SRC& from, std::string& to, ValueConversionTag<ValueConversion::NumberToString> )
+{
+    assign_number( to, from );
+    return ConversionError::Ok;
+}
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC& from, DST& to, ValueConversionTag<ValueConversion::NumberVector> )
+{
+    return convert_vector( from, to );
+}
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC&, DST&, ValueConversionTag<ValueConversion::StringToNumber> )
+{
+    return ConversionError::StringToNumber;
+}
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC&, DST&, ValueConversionTag<ValueConversion::NotAString> )
+{
+    return ConversionError::NotAString;
+}
+
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC&, DST&, ValueConversionTag<ValueConversion::Mismatch> )
+{
+    return ConversionError::TypeMismatch;
+}
+
+// Same rules of Any::tryConvert(), for a value whose type is known at compile time:
+// the dispatch is resolved by the compiler and only the run-time checks remain.
+template <typename SRC, typename DST> inline
+ConversionError convert_value( const SRC& from, DST& to )
+{
+    return convert_value( from, to, value_conversion<SRC, DST>() );
+}
+
+} // end namespace details
+
+
+// Value of one of the types Types... (C++11 equivalent of std::variant, without the
+// valueless state), stored inline: no heap allocation besides the ones of the
+// alternative itself (e.g. a long std::string). It is never empty: a default
+// constructed Variant holds a value-initialized alternative of the first type.
+//
+// visit() dispatches on the index with a chain of comparisons that the compiler
+// inlines, and tryConvert() applies the rules of Any::tryConvert():
+//
+//    Variant<double, int32_t, std::string> value( int32_t(42) );
+//    uint8_t small;
+//    value.tryConvert(small);   // Ok
+//
+template <typename... Types>
+class Variant
+{
+public:
+    static_assert( sizeof...(Types) > 0 && sizeof...(Types) < 256, "Variant: from 1 to 255 alternatives" );
+
+    template <typename T>
+    struct has_alternative : std::integral_constant<bool, details::index_of<T, Types...>::value < sizeof...(Types)> {};
+
+    template <std::size_t I>
+    using alternative = typename std::tuple_element< I, std::tuple<Types...> >::type;
+
+    Variant(): _index(0)
+    {
+        new (&_storage) alternative<0>();
+    }
+
+    template <typename T, typename U = typename std::decay<T>::type,
+              typename = typename std::enable_if< has_alternative<U>::value >::type>
+    Variant(T&& value): _index( details::index_of<U, Types...>::value )
+    {
+        new (&_storage) U( std::forward<T>(value) );
+    }
+
+    Variant(const Variant& other): _index(other._index)
+    {
+        other.visit( CopyTo{&_storage} );
+    }
+
+    Variant(Variant&& other): _index(other._index)
+    {
+        other.visit( MoveTo{&_storage} );
+    }
+
+    ~Variant()
+    {
+        visit( Destroy() );
+    }
+
+    // An alternative of the same type is assigned in place (e.g. reusing the buffer of a string).
+    Variant& operator=(const Variant& other)
+    {
+        if( _index == other._index ) {
+            other.visit( CopyAssignTo{&_storage} );
+        }
+        else if( this != &other ) {
+            Variant copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Variant& operator=(Variant&& other)
+    {
+        if( _index == other._index ) {
+            other.visit( MoveAssignTo{&_storage} );
+        }
+        else {
+            visit( Destroy() );
+            _index = other._index;
+            other.visit( MoveTo{&_storage} );
+        }
+        return *this;
+    }
+
+    template <typename T, typename U = typename std::decay<T>::type>
+    typename std::enable_if< has_alternative<U>::value >::type set(T&& value)
+    {
+        if( U* ptr = get<U>() ) {
+            *ptr = std::forward<T>(value);
+            return;
+        }
+        U copy( std::forward<T>(value) );  // nothing is destroyed if this throws
+        visit( Destroy() );
+        new (&_storage) U( std::move(copy) );
+        _index = details::index_of<U, Types...>::value;
+    }
+
+    // Copy of the value stored in "any", if its type is one of the alternatives
+    // (a SimpleString is stored as std::string). Otherwise returns false.
+    bool assign(const Any& any)
+    {
+        bool found = false;
+        int expand[] = { ( found = found || assignIfStored( any, static_cast<Types*>(nullptr) ), 0 )... };
+        (void)expand;
+        return found;
+    }
+
+    std::size_t index() const { return _index; }
+
+    template <typename T> bool holds() const { return _index == details::index_of<T, Types...>::value; }
+
+    // Pointer to the value if its type is exactly T, nullptr otherwise.
+    template <typename T> const T* get() const
+    {
+        return holds<T>() ? reinterpret_cast<const T*>( &_storage ) : nullptr;
+    }
+
+    template <typename T> T* get()
+    {
+        return holds<T>() ? reinterpret_cast<T*>( &_storage ) : nullptr;
+    }
+
+    // Calls visitor(value) with the stored alternative; all the overloads must return the same type.
+    template <typename Visitor>
+    auto visit(Visitor&& visitor) const -> decltype( visitor( std::declval<const alternative<0>&>() ) )
+    {
+        typedef decltype( visitor( std::declval<const alternative<0>&>() ) ) Result;
+        return visitFrom<Result>( visitor, std::integral_constant<std::size_t, 0>() );
+    }
+
+    template <typename Visitor>
+    auto visit(Visitor&& visitor) -> decltype( visitor( std::declval<alternative<0>&>() ) )
+    {
+        typedef decltype( visitor( std::declval<alternative<0>&>() ) ) Result;
+        return visitFrom<Result>( visitor, std::integral_constant<std::size_t, 0>() );
+    }
+
+    template <typename T> ConversionError tryConvert(T& dst) const
+    {
+        return visit( Convert<T>{dst} );
+    }
+
+    template <typename T> T convert() const
+    {
+        T out;
+        const ConversionError error = tryConvert(out);
+        if( error != ConversionError::Ok ) { details::throwConversionError(error); }
+        return out;
+    }
+
+    // Copy into a SafeAny::Any, assigned in place if it holds the same type.
+    void toAny(Any& out) const
+    {
+        visit( ToAny{out} );
+    }
+
+private:
+
+    static const std::size_t LAST = sizeof...(Types) - 1;
+
+    template <typename Result, typename Visitor, std::size_t I>
+    Result visitFrom(Visitor& visitor, std::integral_constant<std::size_t, I>) const
+    {
+        if( _index == I ) { return visitor( *reinterpret_cast<const alternative<I>*>( &_storage ) ); }
+        return visitFrom<Result>( visitor, std::integral_constant<std::size_t, I + 1>() );
+    }
+
+    template <typename Result, typename Visitor>
+    Result visitFrom(Visitor& visitor, std::integral_constant<std::size_t, LAST>) const
+    {
+        return visitor( *reinterpret_cast<const alternative<LAST>*>( &_storage ) );
+    }
+
+    template <typename Result, typename Visitor, std::size_t I>
+    Result visitFrom(Visitor& visitor, std::integral_constant<std::size_t, I>)
+    {
+        if( _index == I ) { return visitor( *reinterpret_cast<alternative<I>*>( &_storage ) ); }
+        return visitFrom<Result>( visitor, std::integral_constant<std::size_t, I + 1>() );
+    }
+
+    template <typename Result, typename Visitor>
+    Result visitFrom(Visitor& visitor, std::integral_constant<std::size_t, LAST>)
+    {
+        return visitor( *reinterpret_cast<alternative<LAST>*>( &_storage ) );
+    }
+
+    template <typename T> bool assignIfStored(const Any& any, T*)
+    {
+        const T* ptr = any.extractPtr<T>();
+        if( ptr ) { set( *ptr ); }
+        return ptr != nullptr;
+    }
+
+    bool assignIfStored(const Any& any, std::string*)
+    {
+        const SimpleString* ptr = any.extractPtr<SimpleString>();
+        if( !ptr ) { return false; }
+        if( std::string* str = get<std::string>() ) { str->assign( ptr->data(), ptr->size() ); }
+        else { set( ptr->toStdString() ); }
+        return true;
+    }
+
+    struct Destroy
+    {
+        template <typename T> void operator()(T& value) const { value.~T(); }
+    };
+
+    struct CopyTo
+    {
+        void* where;
+        template <typename T> void operator()(const T& value) const { new (where) T(value); }
+    };
+
+    struct MoveTo
+    {
+        void* where;
+        template <typename T> void operator()(T& value) const { new (where) T( std::move(value) ); }
+    };
+
+    struct CopyAssignTo
+    {
+        void* where;
+        template <typename T> void operator()(const T& value) const { *static_cast<T*>(where) = value; }
+    };
+
+    struct MoveAssignTo
+    {
+        void* where;
+        template <typename T> void operator()(T& value) const { *static_cast<T*>(where) = std::move(value); }
+    };
+
+    template <typename DST> struct Convert
+    {
+        DST& dst;
+        template <typename T> ConversionError operator()(const T& value) const
+        {
+            return details::convert_value( value, dst );
+        }
+    };
+
+    struct ToAny
+    {
+        Any& out;
+        template <typename T> void operator()(const T& value) const
+        {
+            if( !out.assignInPlace(value) ) { out = Any(value); }
+        }
+    };
+
+    typename std::aligned_union<1, Types...>::type _storage;
+    uint8_t _index;
+};
+
+} // end namespace SafeAny
+
+#endif // SAFE_ANY_VARIANT_H
@@ -0,0 +1,15 @@
+#include "SafeAny/safe_any.hpp"
+
+// Type with the same name of the one in any_tests.cpp, but local to this
+// translation unit: see the test "LocalTypes".
+namespace{
+struct LocalType
+{
+    double values[4];
+};
+}
+
+SafeAny::Any makeOtherLocalType()
+{
+    return SafeAny::Any( LocalType{ {1.0, 2.0, 3.0, 4.0} } );
+}
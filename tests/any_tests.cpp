@@ -1,11 +1,16 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include "SafeAny/safe_any.hpp"
 
 
 TEST_CASE( "Basic", "Any" )
 {
-    using VarNumber::Any;
+    using SafeAny::Any;
 
     REQUIRE( Any(int(250)).convert<uint8_t>() == 250 );
 
@@ -20,7 +25,7 @@ TEST_CASE( "Basic", "Any" )
 
 TEST_CASE( "String", "Any" )
 {
-    using VarNumber::Any;
+    using SafeAny::Any;
 
     std::string hello("Hello");
 
@@ -29,3 +34,551 @@ TEST_CASE( "String", "Any" )
     REQUIRE( Any(hello).extract<std::string>() == hello);
 
 }
+
+TEST_CASE( "TypeRegistry", "Any" )
+{
+    using SafeAny::Any;
+    typedef linb::detail::type_registry TR;
+
+    struct Foo { int a; };
+    struct Bar { int b; };
+
+    REQUIRE( Any().typeId() == TR::id_void );
+    REQUIRE( Any(int32_t(1)).typeId() == TR::id_int32 );
+    REQUIRE( Any(double(1)).typeId() == TR::id_double );
+
+    const uint32_t foo_id = Any(Foo{1}).typeId();
+    REQUIRE( foo_id >= TR::first_user_id );
+    REQUIRE( Any(Foo{2}).typeId() == foo_id );
+    REQUIRE( Any(Bar{2}).typeId() != foo_id );
+
+    REQUIRE( Any(Foo{3}).extract<Foo>().a == 3 );
+    REQUIRE_THROWS( Any(Foo{3}).extract<Bar>() );
+}
+
+TEST_CASE( "MemoryResource", "Any" )
+{
+    linb::arena_resource arena(1024);
+
+    const std::vector<double> vect(100, 1.5);
+    linb::any a( std::allocator_arg, &arena, vect );
+    REQUIRE( a.resource() == &arena );
+    REQUIRE( arena.bytes_allocated() == sizeof(std::vector<double>) );
+    REQUIRE( linb::any_cast<std::vector<double>>(a) == vect );
+
+    // plain copies use the default heap, they can outlive the arena
+    linb::any copy(a);
+    REQUIRE( copy.resource() == nullptr );
+    linb::any arena_copy( std::allocator_arg, &arena, copy );
+    REQUIRE( arena_copy.resource() == &arena );
+
+    // values stored in the small buffer don't allocate
+    linb::any number( std::allocator_arg, &arena, 42 );
+    REQUIRE( number.resource() == nullptr );
+
+    // the buffer of the string is allocated from the arena too
+    SafeAny::SimpleString str( std::string(200, 'x'), &arena );
+    REQUIRE( str.resource() == &arena );
+    const std::size_t before = arena.bytes_allocated();
+    linb::any any_str( std::allocator_arg, &arena, str );
+    REQUIRE( arena.bytes_allocated() > before + 200 );
+    REQUIRE( linb::any_cast<SafeAny::SimpleString>(&any_str)->resource() == &arena );
+    REQUIRE( SafeAny::SimpleString( *linb::any_cast<SafeAny::SimpleString>(&any_str) ).resource() == nullptr );
+}
+
+TEST_CASE( "SharedPayload", "Any" )
+{
+    const std::vector<double> vect(1000, 1.5);
+    SafeAny::Any a = SafeAny::Any::makeShared( vect );
+    REQUIRE( a.isShared() );
+    REQUIRE( a.extract<std::vector<double>>() == vect );
+
+    // copies refer to the same object, also the ones allocated from a resource
+    SafeAny::Any copy(a);
+    linb::arena_resource arena;
+    SafeAny::Any arena_copy( std::allocator_arg, &arena, a );
+    REQUIRE( copy.extractPtr<std::vector<double>>() == a.extractPtr<std::vector<double>>() );
+    REQUIRE( arena_copy.extractPtr<std::vector<double>>() == a.extractPtr<std::vector<double>>() );
+    REQUIRE( arena.bytes_allocated() == 0 );
+
+    // immutable
+    REQUIRE( copy.extractMutablePtr<std::vector<double>>() == nullptr );
+    REQUIRE( !copy.assignInPlace( std::vector<double>(3, 2.0) ) );
+    REQUIRE( !copy.assignInPlace( SafeAny::Any(std::vector<double>(3, 2.0)) ) );
+    copy = std::vector<double>(3, 2.0);
+    REQUIRE( !copy.isShared() );
+    REQUIRE( a.extract<std::vector<double>>() == vect );
+
+    // small types and strings
+    SafeAny::Any number = SafeAny::Any::makeShared( 42 );
+    SafeAny::Any number_copy = number;
+    REQUIRE( number_copy.convert<double>() == 42.0 );
+    REQUIRE( number_copy.extractPtr<int>() == number.extractPtr<int>() );
+
+    SafeAny::Any str = SafeAny::Any::makeShared( std::string("hello") );
+    REQUIRE( str.convert<std::string>() == "hello" );
+
+    // moved and swapped like the other values
+    linb::any la( linb::shared_payload, std::string("world") );
+    linb::any lb( 1.5 );
+    la.swap(lb);
+    REQUIRE( linb::any_cast<double>(la) == 1.5 );
+    REQUIRE( linb::any_cast<std::string>(lb) == "world" );
+    REQUIRE_THROWS_AS( linb::any_cast<std::string&>(lb), linb::bad_any_cast );
+}
+
+TEST_CASE( "TryConvert", "Any" )
+{
+    using SafeAny::Any;
+    using SafeAny::ConversionError;
+
+    uint8_t small = 7;
+    REQUIRE( Any(int(250)).tryConvert(small) == ConversionError::Ok );
+    REQUIRE( small == 250 );
+
+    // on failure the destination is not modified
+    REQUIRE( Any(int(300)).tryConvert(small) == ConversionError::TooLarge );
+    REQUIRE( Any(int(-1)).tryConvert(small) == ConversionError::Negative );
+    REQUIRE( Any(int(-300)).tryConvert(small) == ConversionError::Negative );
+    int8_t tiny = 0;
+    REQUIRE( Any(int(-300)).tryConvert(tiny) == ConversionError::TooSmall );
+    REQUIRE( Any(double(1.5)).tryConvert(small) == ConversionError::Truncated );
+    REQUIRE( Any(double(1e10)).tryConvert(tiny) == ConversionError::TooLarge );
+    REQUIRE( Any(std::string("42")).tryConvert(small) == ConversionError::StringToNumber );
+    REQUIRE( Any(std::vector<int>()).tryConvert(small) == ConversionError::TypeMismatch );
+    REQUIRE( small == 250 );
+    REQUIRE( tiny == 0 );
+
+    std::string str;
+    REQUIRE( Any(int(42)).tryConvert(str) == ConversionError::Ok );
+    REQUIRE( str == "42" );
+    REQUIRE( Any(std::vector<int>()).tryConvert(str) == ConversionError::NotAString );
+
+    std::vector<int> vect;
+    REQUIRE( Any(std::vector<int>(3, 1)).tryConvert(vect) == ConversionError::Ok );
+    REQUIRE( vect.size() == 3 );
+    REQUIRE( Any(int(1)).tryConvert(vect) == ConversionError::TypeMismatch );
+
+    // convert() throws the same errors
+    REQUIRE_THROWS_AS( Any(int(300)).convert<uint8_t>(), std::runtime_error );
+    REQUIRE_THROWS_AS( Any(int(1)).convert<std::vector<int>>(), linb::bad_any_cast );
+    REQUIRE( std::string( SafeAny::toString(ConversionError::TooLarge) ) == "Value too large." );
+}
+
+// Values of SRC that exercise the limits of every conversion.
+template <typename SRC>
+static std::vector<SRC> probeValues()
+{
+    typedef std::numeric_limits<SRC> limits;
+    std::vector<SRC> values = { SRC(0), SRC(1), limits::lowest(), limits::max() };
+    if( limits::is_signed ) { values.push_back( SRC(-1) ); }
+    if( !limits::is_integer ) { values.push_back( SRC(0.5) ); }
+    return values;
+}
+
+template <> std::vector<bool> probeValues<bool>() { return { false, true }; }
+
+template <> std::vector<std::string> probeValues<std::string>() { return { "", "42" }; }
+
+template <typename SRC, typename DST>
+static void checkConversionKind()
+{
+    using SafeAny::ConversionKind;
+    using SafeAny::ConversionError;
+    // strings are stored as SimpleString
+    typedef typename std::conditional<std::is_same<SRC, std::string>::value, SafeAny::SimpleString, SRC>::type Stored;
+    const ConversionKind kind = SafeAny::conversionKind<Stored, DST>();
+
+    int failures = 0;
+    const std::vector<SRC> values = probeValues<SRC>();
+    for(const SRC& value: values)
+    {
+        DST out = DST();
+        const ConversionError error = SafeAny::Any(value).tryConvert(out);
+        failures += ( error != ConversionError::Ok );
+        if( kind == ConversionKind::Identity || kind == ConversionKind::Widening )
+        {
+            INFO( typeid(SRC).name() << " -> " << typeid(DST).name() );
+            REQUIRE( error == ConversionError::Ok );
+        }
+    }
+    INFO( typeid(SRC).name() << " -> " << typeid(DST).name() << " kind " << int(kind) );
+    if( kind == ConversionKind::Impossible ) {
+        REQUIRE( failures == int(values.size()) );
+    }
+    if( kind == ConversionKind::CheckedNarrowing ) {
+        // some values fail, but not all
+        REQUIRE( failures > 0 );
+        REQUIRE( failures < int(values.size()) );
+    }
+}
+
+template <typename SRC, typename... DST>
+static void checkConversionRow()
+{
+    int expand[] = { (checkConversionKind<SRC, DST>(), 0)... };
+    (void)expand;
+}
+
+#define CONVERSION_DESTINATIONS bool, char, int8_t, int16_t, int32_t, int64_t, \
+    uint8_t, uint16_t, uint32_t, uint64_t, float, double, std::string
+
+TEST_CASE( "ConversionMatrix", "Any" )
+{
+    using SafeAny::ConversionKind;
+    using SafeAny::conversionKind;
+
+    static_assert( conversionKind<int32_t, int32_t>() == ConversionKind::Identity, "" );
+    static_assert( conversionKind<int16_t, int64_t>() == ConversionKind::Widening, "" );
+    static_assert( conversionKind<uint16_t, int32_t>() == ConversionKind::Widening, "" );
+    static_assert( conversionKind<int16_t, uint32_t>() == ConversionKind::CheckedNarrowing, "" );
+    static_assert( conversionKind<int32_t, double>() == ConversionKind::Widening, "" );
+    static_assert( conversionKind<int32_t, float>() == ConversionKind::CheckedNarrowing, "" );
+    static_assert( conversionKind<float, double>() == ConversionKind::Widening, "" );
+    static_assert( conversionKind<double, int64_t>() == ConversionKind::CheckedNarrowing, "" );
+    static_assert( conversionKind<SafeAny::SimpleString, int>() == ConversionKind::Impossible, "" );
+    static_assert( conversionKind<SafeAny::SimpleString, std::string>() == ConversionKind::Identity, "" );
+    static_assert( conversionKind<int, bool>() == ConversionKind::Impossible, "" );
+    static_assert( conversionKind<std::vector<int>, int>() == ConversionKind::Impossible, "" );
+
+    checkConversionRow<bool,        CONVERSION_DESTINATIONS>();
+    checkConversionRow<char,        CONVERSION_DESTINATIONS>();
+    checkConversionRow<int8_t,      CONVERSION_DESTINATIONS>();
+    checkConversionRow<int16_t,     CONVERSION_DESTINATIONS>();
+    checkConversionRow<int32_t,     CONVERSION_DESTINATIONS>();
+    checkConversionRow<int64_t,     CONVERSION_DESTINATIONS>();
+    checkConversionRow<uint8_t,     CONVERSION_DESTINATIONS>();
+    checkConversionRow<uint16_t,    CONVERSION_DESTINATIONS>();
+    checkConversionRow<uint32_t,    CONVERSION_DESTINATIONS>();
+    checkConversionRow<uint64_t,    CONVERSION_DESTINATIONS>();
+    checkConversionRow<float,       CONVERSION_DESTINATIONS>();
+    checkConversionRow<double,      CONVERSION_DESTINATIONS>();
+    checkConversionRow<std::string, CONVERSION_DESTINATIONS>();
+}
+
+// NaN included
+template <typename T>
+static bool sameValue(const T& a, const T& b) { return a == b || (a != a && b != b); }
+
+template <typename DST>
+static void checkConvertRange(const std::vector<SafeAny::Any>& values, const DST& initial)
+{
+    std::unique_ptr<DST[]> batch( new DST[values.size()] );
+    std::fill( batch.get(), batch.get() + values.size(), initial );
+    std::vector<std::size_t> failed;
+    const std::size_t failures = SafeAny::convertRange( values.data(), values.data() + values.size(),
+                                                        batch.get(), &failed );
+    REQUIRE( failures == failed.size() );
+
+    // same results of tryConvert(), one value at a time
+    std::size_t next_failed = 0;
+    for(std::size_t i=0; i<values.size(); i++)
+    {
+        DST scalar = initial;
+        const bool ok = values[i].tryConvert(scalar) == SafeAny::ConversionError::Ok;
+        INFO( "index " << i << " to " << typeid(DST).name() );
+        REQUIRE( ok == !(next_failed < failed.size() && failed[next_failed] == i) );
+        REQUIRE( sameValue( batch[i], scalar ) );
+        if( !ok ) { next_failed++; }
+    }
+}
+
+TEST_CASE( "ConvertRange", "Any" )
+{
+    using SafeAny::Any;
+
+    std::vector<Any> values;
+    for(int i=0; i<600; i++)
+    {
+        const double x = (i % 2 ? 1.0 : -1.0) * std::ldexp( 1.0, i % 70 ) + (i % 7 == 0 ? 0.5 : 0.0);
+        switch( i % 9 )
+        {
+        case 0: values.push_back( Any( double(x) ) ); break;
+        case 1: values.push_back( Any( float(x) ) ); break;
+        case 2: values.push_back( Any( int32_t( std::max(-2e9, std::min(2e9, x)) ) ) ); break;
+        case 3: values.push_back( Any( int64_t( std::max(-9e18, std::min(9e18, x)) ) ) ); break;
+        case 4: values.push_back( Any( uint16_t( i * 97 ) ) ); break;
+        case 5: values.push_back( Any( uint64_t( std::numeric_limits<uint64_t>::max() - i ) ) ); break;
+        case 6: values.push_back( Any( bool(i % 2) ) ); break;
+        case 7: values.push_back( Any( char(i % 128) ) ); break;
+        case 8: values.push_back( i % 2 ? Any( std::string("text") ) : Any( int8_t(-i % 128) ) ); break;
+        }
+    }
+    values.push_back( Any( std::numeric_limits<double>::quiet_NaN() ) );
+    values.push_back( Any() );
+
+    checkConvertRange<double>( values, double(7) );
+    checkConvertRange<float>( values, float(7) );
+    checkConvertRange<int8_t>( values, int8_t(7) );
+    checkConvertRange<uint8_t>( values, uint8_t(7) );
+    checkConvertRange<int32_t>( values, int32_t(7) );
+    checkConvertRange<uint32_t>( values, uint32_t(7) );
+    checkConvertRange<int64_t>( values, int64_t(7) );
+    checkConvertRange<uint64_t>( values, uint64_t(7) );
+    checkConvertRange<char>( values, char(7) );
+    checkConvertRange<bool>( values, true );
+    checkConvertRange<std::string>( values, std::string("none") );
+
+    // a single type (the values that don't fit int8_t fail)
+    std::vector<Any> doubles;
+    for(int i=0; i<300; i++) { doubles.push_back( Any( double(i) - 150.0 ) ); }
+    checkConvertRange<int8_t>( doubles, int8_t(7) );
+    checkConvertRange<uint16_t>( doubles, uint16_t(7) );
+    checkConvertRange<float>( doubles, float(7) );
+
+    // without the list of failures
+    std::vector<double> out( values.size() );
+    REQUIRE( SafeAny::convertRange( values.data(), values.data() + values.size(), out.data() ) > 0 );
+}
+
+TEST_CASE( "VectorConversion", "Any" )
+{
+    using SafeAny::Any;
+    using SafeAny::ConversionError;
+    using SafeAny::ConversionKind;
+
+    std::vector<int32_t> ints;
+    for(int i=0; i<1000; i++) { ints.push_back( i * 37 - 5000 ); }
+    Any any_ints( ints );
+
+    // widening
+    std::vector<double> doubles = any_ints.convert<std::vector<double>>();
+    REQUIRE( doubles.size() == ints.size() );
+    for(std::size_t i=0; i<ints.size(); i++) { REQUIRE( doubles[i] == double(ints[i]) ); }
+
+    std::vector<int64_t> longs;
+    REQUIRE( any_ints.tryConvert( longs ) == ConversionError::Ok );
+    REQUIRE( longs.back() == ints.back() );
+
+    // negative values: the destination is left unchanged
+    std::vector<uint32_t> unsigned_ints( 3, 7 );
+    REQUIRE( any_ints.tryConvert( unsigned_ints ) == ConversionError::Negative );
+    REQUIRE( unsigned_ints == std::vector<uint32_t>( 3, 7 ) );
+    REQUIRE_THROWS( any_ints.convert<std::vector<uint32_t>>() );
+
+    // narrowing, checked on the minimum and the maximum
+    std::vector<uint16_t> words = { 0, 10, 255, 3 };
+    std::vector<uint8_t> bytes;
+    REQUIRE( Any( words ).tryConvert( bytes ) == ConversionError::Ok );
+    REQUIRE( bytes == std::vector<uint8_t>( { 0, 10, 255, 3 } ) );
+    words[2] = 256;
+    REQUIRE( Any( words ).tryConvert( bytes ) == ConversionError::TooLarge );
+    REQUIRE( bytes == std::vector<uint8_t>( { 0, 10, 255, 3 } ) );
+
+    // every element is checked for truncation
+    std::vector<double> reals = { 1.0, -2.0, 1e6 };
+    std::vector<int32_t> out;
+    REQUIRE( Any( reals ).tryConvert( out ) == ConversionError::Ok );
+    REQUIRE( out == std::vector<int32_t>( { 1, -2, 1000000 } ) );
+    reals.push_back( 0.5 );
+    REQUIRE( Any( reals ).tryConvert( out ) == ConversionError::Truncated );
+
+    std::vector<float> floats;
+    REQUIRE( Any( std::vector<double>( { 0.5, 0.25 } ) ).tryConvert( floats ) == ConversionError::Ok );
+    REQUIRE( Any( std::vector<double>( { 0.5, 0.1 } ) ).tryConvert( floats ) == ConversionError::Truncated );
+
+    // the same rules of the scalars
+    REQUIRE( (SafeAny::conversionKind<std::vector<int32_t>, std::vector<double>>() == ConversionKind::Widening) );
+    REQUIRE( (SafeAny::conversionKind<std::vector<uint16_t>, std::vector<uint8_t>>() == ConversionKind::CheckedNarrowing) );
+    REQUIRE( (SafeAny::conversionKind<std::vector<int32_t>, std::vector<bool>>() == ConversionKind::Impossible) );
+
+    // empty vectors and other types
+    REQUIRE( Any( std::vector<int8_t>() ).tryConvert( floats ) == ConversionError::Ok );
+    REQUIRE( floats.empty() );
+    REQUIRE( Any( 42 ).tryConvert( floats ) == ConversionError::TypeMismatch );
+    REQUIRE( Any( std::vector<std::string>( 2 ) ).tryConvert( floats ) == ConversionError::TypeMismatch );
+}
+
+TEST_CASE( "FormatNumber", "Any" )
+{
+    using SafeAny::Any;
+
+    REQUIRE( Any(int8_t(-128)).convert<std::string>() == "-128" );
+    REQUIRE( Any(std::numeric_limits<int64_t>::min()).convert<std::string>() == "-9223372036854775808" );
+    REQUIRE( Any(std::numeric_limits<uint64_t>::max()).convert<std::string>() == "18446744073709551615" );
+    REQUIRE( Any(true).convert<std::string>() == "1" );
+    REQUIRE( Any('A').convert<std::string>() == "65" );
+
+    REQUIRE( Any(0.1).convert<std::string>() == "0.1" );
+    REQUIRE( Any(250.0).convert<std::string>() == "250" );
+    REQUIRE( Any(-1.25).convert<std::string>() == "-1.25" );
+    REQUIRE( Any(0.000001).convert<std::string>() == "0.000001" );
+    REQUIRE( Any(1.5e-7).convert<std::string>() == "1.5e-7" );
+    REQUIRE( Any(1e21).convert<std::string>() == "1e+21" );
+    REQUIRE( Any(123456789012.5).convert<std::string>() == "123456789012.5" );
+    REQUIRE( Any(std::numeric_limits<double>::max()).convert<std::string>() == "1.7976931348623157e+308" );
+    REQUIRE( Any(std::numeric_limits<double>::denorm_min()).convert<std::string>() == "5e-324" );
+    REQUIRE( Any(0.1f).convert<std::string>() == "0.1" );
+    REQUIRE( Any(std::numeric_limits<float>::max()).convert<std::string>() == "3.4028235e+38" );
+    REQUIRE( Any(-0.0).convert<std::string>() == "-0" );
+    REQUIRE( Any(std::numeric_limits<double>::quiet_NaN()).convert<std::string>() == "nan" );
+    REQUIRE( Any(-std::numeric_limits<float>::infinity()).convert<std::string>() == "-inf" );
+
+    // round trip of random bit patterns
+    uint64_t state = 88172645463325252ULL;
+    for(int i=0; i<100000; i++)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+
+        double number;
+        std::memcpy( &number, &state, sizeof(number) );
+        char buffer[SafeAny::NUMBER_BUFFER_SIZE + 1];
+        if( std::isfinite(number) )
+        {
+            *SafeAny::formatNumber( buffer, number ) = 0;
+            REQUIRE( std::strtod( buffer, nullptr ) == number );
+        }
+        float single;
+        const uint32_t low = static_cast<uint32_t>(state);
+        std::memcpy( &single, &low, sizeof(single) );
+        if( std::isfinite(single) )
+        {
+            *SafeAny::formatNumber( buffer, single ) = 0;
+            REQUIRE( std::strtof( buffer, nullptr ) == single );
+        }
+    }
+}
+
+TEST_CASE( "ParseNumber", "Any" )
+{
+    using SafeAny::Any;
+    using SafeAny::ConversionError;
+
+    Any text( std::string("-42") );
+    REQUIRE( text.parse<int>() == -42 );
+    REQUIRE( text.parse<double>() == -42.0 );
+    REQUIRE( text.parse<int>() == -42 );   // cached
+    REQUIRE_THROWS( text.convert<int>() );
+
+    uint8_t small = 7;
+    REQUIRE( text.tryParse(small) == ConversionError::Negative );
+    REQUIRE( Any( std::string("256") ).tryParse(small) == ConversionError::TooLarge );
+    REQUIRE( Any( std::string("2.5") ).tryParse(small) == ConversionError::Truncated );
+    REQUIRE( Any( std::string("1e2") ).tryParse(small) == ConversionError::Ok );
+    REQUIRE( small == 100 );
+    REQUIRE( Any( std::string("12 ") ).tryParse(small) == ConversionError::InvalidNumber );
+    REQUIRE( small == 100 );
+
+    REQUIRE( Any( std::string("18446744073709551615") ).parse<uint64_t>() == std::numeric_limits<uint64_t>::max() );
+    REQUIRE( Any( std::string("-9223372036854775808") ).parse<int64_t>() == std::numeric_limits<int64_t>::min() );
+    REQUIRE( Any( std::string("0.1") ).parse<float>() == 0.1f );
+    float single = 0;
+    REQUIRE( Any( std::string("1e39") ).tryParse(single) == ConversionError::TooLarge );
+    double real = 0;
+    REQUIRE( Any( std::string("-1e400") ).tryParse(real) == ConversionError::TooSmall );
+    REQUIRE( std::isinf( Any( std::string("-inf") ).parse<double>() ) );
+    REQUIRE( Any( std::string("true") ).parse<bool>() == true );
+    REQUIRE( Any( std::string("0") ).parse<bool>() == false );
+    bool flag = false;
+    REQUIRE( Any( std::string("2") ).tryParse(flag) == ConversionError::NotConvertible );
+
+    // other values are converted as usual
+    REQUIRE( Any( 3.0 ).parse<int>() == 3 );
+    REQUIRE( Any( std::string("abc") ).parse<std::string>() == "abc" );
+
+    // correctly rounded, like strtod()
+    const char* texts[] = { "0.1", "3.14159265358979323846264338327950288", "1e-320", "2.2250738585072011e-308",
+                            "9007199254740993.0", "179769313486231570000000000000000000000000000000000000000000000e246",
+                            "0.000000000000000000000000000000000000000000000000000000000000000000001234" };
+    for(const char* str: texts)
+    {
+        double value = 0;
+        REQUIRE( SafeAny::parseNumber( str, str + strlen(str), value ) == ConversionError::Ok );
+        REQUIRE( value == std::strtod( str, nullptr ) );
+    }
+
+    // round trip with formatNumber()
+    uint64_t state = 88172645463325252ULL;
+    for(int i=0; i<10000; i++)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        double number;
+        std::memcpy( &number, &state, sizeof(number) );
+        if( !std::isfinite(number) ) { continue; }
+        char buffer[SafeAny::NUMBER_BUFFER_SIZE];
+        double parsed = 0;
+        REQUIRE( SafeAny::parseNumber( buffer, SafeAny::formatNumber( buffer, number ), parsed ) == ConversionError::Ok );
+        REQUIRE( parsed == number );
+    }
+}
+
+TEST_CASE( "NumberAny", "Any" )
+{
+    using SafeAny::Any;
+    using SafeAny::NumberAny;
+    using SafeAny::ConversionError;
+
+    REQUIRE( sizeof(NumberAny) == 16 );
+    // the union with linb::any plus the flag telling which one is stored (see Any)
+    REQUIRE( sizeof(Any) == sizeof(linb::any) + alignof(linb::any) );
+
+    NumberAny number( int16_t(-300) );
+    REQUIRE( number.typeId() == linb::detail::type_id<int16_t>() );
+    REQUIRE( number.type() == typeid(int16_t) );
+    REQUIRE( *number.get<int16_t>() == -300 );
+    REQUIRE( number.get<int32_t>() == nullptr );
+    REQUIRE( number.convert<double>() == -300.0 );
+    uint8_t small = 7;
+    REQUIRE( number.tryConvert(small) == ConversionError::Negative );
+    REQUIRE( small == 7 );
+
+    number.set( 2.5f );
+    REQUIRE( number.type() == typeid(float) );
+    REQUIRE( number.convert<double>() == 2.5 );
+    REQUIRE( NumberAny().empty() );
+    REQUIRE( NumberAny().type() == typeid(void) );
+
+    // Any stores the numbers in a NumberAny, the other values in a linb::any
+    Any value( uint32_t(42) );
+    REQUIRE( value.typeId() == linb::detail::type_id<uint32_t>() );
+    REQUIRE( value.isArithmetic() );
+    REQUIRE( value.convert<int8_t>() == 42 );
+    REQUIRE( value.convert<std::string>() == "42" );
+    REQUIRE( value.assignInPlace( uint32_t(43) ) );
+    REQUIRE( !value.assignInPlace( 43.0 ) );
+    REQUIRE( value.extract<uint32_t>() == 43 );
+    REQUIRE_THROWS_AS( value.extract<int32_t>(), linb::bad_any_cast );
+
+    // switching between the two storages
+    value = std::string("hello");
+    REQUIRE( value.convert<std::string>() == "hello" );
+    Any copy( value );
+    value = 1.5;
+    REQUIRE( value.convert<double>() == 1.5 );
+    copy = value;
+    REQUIRE( copy.type() == typeid(double) );
+    copy.emplace<std::vector<int>>( 3, 1 );
+    REQUIRE( copy.extractPtr<std::vector<int>>()->size() == 3 );
+    copy.emplace<int64_t>( -5 );
+    REQUIRE( copy.convert<int>() == -5 );
+    REQUIRE( !copy.assignInPlace( value ) );
+    value = int64_t(8);
+    REQUIRE( copy.assignInPlace( value ) );
+    REQUIRE( copy.convert<int>() == 8 );
+
+    // long long is not one of the intN_t on LP64: stored in the linb::any
+    Any other( 5LL );
+    REQUIRE( other.extract<long long>() == 5 );
+    REQUIRE( Any().typeId() == 0 );
+}
+
+// defined in any_local_type.cpp, with another type called LocalType
+SafeAny::Any makeOtherLocalType();
+
+namespace{
+struct LocalType
+{
+    std::string name;
+};
+}
+
+TEST_CASE( "LocalTypes", "Any" )
+{
+    // same mangled name, different types: they must have different ids
+    const SafeAny::Any other = makeOtherLocalType();
+    const SafeAny::Any mine( LocalType{"mine"} );
+    REQUIRE( other.typeId() != mine.typeId() );
+    REQUIRE( other.extractPtr<LocalType>() == nullptr );
+    REQUIRE( mine.extractPtr<LocalType>()->name == "mine" );
+    REQUIRE_THROWS_AS( other.extract<LocalType>(), linb::bad_any_cast );
+}
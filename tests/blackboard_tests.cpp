@@ -0,0 +1,746 @@
+#include "catch.hpp"
+#include <sys/wait.h>
+#include <signal.h>
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_shm.h"
+#include "Blackboard/blackboard_image.h"
+#include "Blackboard/blackboard_concurrent.h"
+#include "Blackboard/blackboard_variant.h"
+#include "Blackboard/blackboard_compact.h"
+#include <thread>
+#include <limits>
+
+
+TEST_CASE( "Local", "Blackboard" )
+{
+    Blackboard bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal) );
+
+    int num = 0;
+    std::string str;
+
+    REQUIRE( !bb.get("num", num) );
+
+    bb.set("num", 42);
+    bb.set("str", "hello");
+
+    REQUIRE( bb.get("num", num) );
+    REQUIRE( num == 42 );
+    REQUIRE( bb.get("str", str) );
+    REQUIRE( str == "hello" );
+}
+
+TEST_CASE( "TryGet", "Blackboard" )
+{
+    Blackboard bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal) );
+    bb.set("num", 300);
+
+    int num = 0;
+    uint8_t small = 0;
+    REQUIRE( bb.tryGet("num", num) == SafeAny::ConversionError::Ok );
+    REQUIRE( num == 300 );
+    REQUIRE( bb.tryGet("num", small) == SafeAny::ConversionError::TooLarge );
+    REQUIRE( bb.tryGet("missing", num) == SafeAny::ConversionError::MissingKey );
+    REQUIRE( small == 0 );
+}
+
+TEST_CASE( "TryParse", "Blackboard" )
+{
+    Blackboard bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal) );
+    bb.set("gain", std::string("0.25"));
+    bb.set("count", std::string("300"));
+
+    double gain = 0;
+    uint8_t small = 0;
+    REQUIRE( bb.tryParse("gain", gain) == SafeAny::ConversionError::Ok );
+    REQUIRE( gain == 0.25 );
+    REQUIRE( bb.tryParse("count", small) == SafeAny::ConversionError::TooLarge );
+    // parsing is opt-in
+    REQUIRE( bb.tryGet("gain", gain) == SafeAny::ConversionError::StringToNumber );
+
+    // the cached number follows the value
+    bb.set("gain", std::string("0.5"));
+    REQUIRE( bb.tryParse("gain", gain) == SafeAny::ConversionError::Ok );
+    REQUIRE( gain == 0.5 );
+    bb.set("gain", std::string("high"));
+    REQUIRE( bb.tryParse("gain", gain) == SafeAny::ConversionError::InvalidNumber );
+    REQUIRE( bb.tryParse("missing", gain) == SafeAny::ConversionError::MissingKey );
+}
+
+TEST_CASE( "ConversionCache", "Blackboard" )
+{
+    std::unique_ptr<BlackboardLocal> local( new BlackboardLocal );
+    local->setConversionCache(true);
+    Blackboard bb( std::move(local) );
+    bb.set("num", int32_t(300));
+
+    double real = 0;
+    REQUIRE( bb.tryGet("num", real) == SafeAny::ConversionError::Ok );
+    REQUIRE( bb.tryGet("num", real) == SafeAny::ConversionError::Ok );
+    REQUIRE( real == 300.0 );
+
+    // failures are not cached, other types replace the cached one
+    uint8_t small = 0;
+    REQUIRE( bb.tryGet("num", small) == SafeAny::ConversionError::TooLarge );
+    int64_t large = 0;
+    REQUIRE( bb.get("num", large) );
+    REQUIRE( large == 300 );
+    REQUIRE_THROWS( bb.get("num", small) );
+
+    // numbers larger than the cache are converted every time
+    long double extended = 0;
+    REQUIRE( bb.get("num", extended) );
+    REQUIRE( bb.get("num", extended) );
+    REQUIRE( extended == 300.0L );
+    SafeAny::ConversionCache cache;
+    REQUIRE( cache.convert( SafeAny::Any(3.0), extended ) == SafeAny::ConversionError::Ok );
+    REQUIRE( extended == 3.0L );
+
+    // invalidated by every change of the value
+    bb.set("num", int32_t(7));
+    REQUIRE( bb.get("num", real) );
+    REQUIRE( real == 7.0 );
+    bb.set("num", 2.5);
+    REQUIRE( bb.get("num", real) );
+    REQUIRE( real == 2.5 );
+    bb.emplace<int32_t>("num", 9);
+    REQUIRE( bb.get("num", real) );
+    REQUIRE( real == 9.0 );
+    bb.set("num", std::string("text"));
+    REQUIRE( bb.tryGet("num", real) == SafeAny::ConversionError::StringToNumber );
+}
+
+TEST_CASE( "LocalArena", "Blackboard" )
+{
+    linb::arena_resource arena;
+    {
+        BlackboardLocal* local = new BlackboardLocal(&arena);
+        Blackboard bb( ( std::unique_ptr<BlackboardLocal>(local) ) );
+
+        const std::string long_key(100, 'k');
+        const std::string long_str(100, 's');
+        const std::vector<double> vect(10, 3.0);
+
+        // the front-end passes the values as rvalues: they are copied into the arena anyway
+        bb.set(long_key, long_str);
+        bb.set("vect", vect);
+        bb.set("num", 42);
+        bb.set("num", 43);
+        REQUIRE( arena.bytes_allocated() >= long_key.size() + long_str.size() + sizeof(vect) );
+        REQUIRE( local->get(long_key)->extractPtr<SafeAny::SimpleString>()->resource() == &arena );
+
+        // assigned in place, still in the arena
+        bb.set(long_key, std::string(200, 't'));
+        REQUIRE( local->get(long_key)->extractPtr<SafeAny::SimpleString>()->resource() == &arena );
+
+        std::string str;
+        std::vector<double> vect_out;
+        int num = 0;
+        REQUIRE( bb.get(long_key, str) );
+        REQUIRE( str == std::string(200, 't') );
+        REQUIRE( bb.get("vect", vect_out) );
+        REQUIRE( vect_out == vect );
+        REQUIRE( bb.get("num", num) );
+        REQUIRE( num == 43 );
+        REQUIRE( !bb.get("missing", num) );
+    }
+    REQUIRE( arena.chunk_count() == 1 );
+}
+
+TEST_CASE( "SharedMemory", "Blackboard" )
+{
+    const std::string name("/blackboard_shm_test");
+    BlackboardShm::remove(name);
+
+    Blackboard writer( std::unique_ptr<BlackboardShm>( new BlackboardShm(name, 64) ) );
+    Blackboard reader( std::unique_ptr<BlackboardShm>( new BlackboardShm(name) ) );
+
+    writer.set("num", int32_t(250));
+    writer.set("real", 3.5);
+    writer.set("str", "hello");
+
+    uint8_t num = 0;
+    double real = 0;
+    std::string str;
+
+    REQUIRE( reader.get("num", num) );
+    REQUIRE( num == 250 );
+    REQUIRE( reader.get("real", real) );
+    REQUIRE( real == 3.5 );
+    REQUIRE( reader.get("str", str) );
+    REQUIRE( str == "hello" );
+    REQUIRE( !reader.get("missing", num) );
+
+    writer.set("num", int32_t(300));
+    REQUIRE_THROWS( reader.get("num", num) );
+
+    writer.set("str", "a string longer than the previous one");
+    REQUIRE( reader.get("str", str) );
+    REQUIRE( str == "a string longer than the previous one" );
+
+    REQUIRE_THROWS( writer.set("vect", std::vector<int>(3) ) );
+
+    // write from another process
+    pid_t pid = fork();
+    if( pid == 0 )
+    {
+        BlackboardShm child(name);
+        child.set("from_child", 7);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    int from_child = 0;
+    REQUIRE( reader.get("from_child", from_child) );
+    REQUIRE( from_child == 7 );
+
+    BlackboardShm::remove(name);
+
+    // a segment whose creator died before initializing it
+    const int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666 );
+    REQUIRE( fd >= 0 );
+    REQUIRE( ftruncate(fd, 4096) == 0 );
+    close(fd);
+    REQUIRE_THROWS_AS( BlackboardShm(name), std::runtime_error );
+
+    BlackboardShm::remove(name);
+}
+
+TEST_CASE( "SharedMemoryThreads", "Blackboard" )
+{
+    const std::string name("/blackboard_shm_threads");
+    BlackboardShm::remove(name);
+    BlackboardShm board(name, 64);
+    board.set( "str", SafeAny::Any(std::string("hello")) );
+
+    // each thread reads its own copies
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; t++)
+    {
+        threads.emplace_back( [&board, &errors, t]() {
+            for (int i=0; i<1000; i++)
+            {
+                const std::string key = "num_" + std::to_string(t);
+                board.set( key, SafeAny::Any(i) );
+                const SafeAny::Any* str = board.get("str");
+                const SafeAny::Any* num = board.get(key);
+                if( !str || str->extract<std::string>() != "hello" ) { errors++; }
+                if( !num || num->convert<int>() != i ) { errors++; }
+            }
+        } );
+    }
+    for(auto& thread: threads) { thread.join(); }
+    REQUIRE( errors == 0 );
+
+    BlackboardShm::remove(name);
+}
+
+TEST_CASE( "SharedMemoryDeadWriter", "Blackboard" )
+{
+    const std::string name("/blackboard_shm_dead_writer");
+    BlackboardShm::remove(name);
+
+    // large strings: the writer spends most of its time inside the critical section
+    const std::string first(1 << 20, 'a');
+    const std::string second(1 << 20, 'b');
+    BlackboardShm board(name, 16, 4 << 20);
+    board.set( "big", SafeAny::Any(first) );
+
+    for (int round=0; round<5; round++)
+    {
+        pid_t pid = fork();
+        if( pid == 0 )
+        {
+            BlackboardShm child(name);
+            const SafeAny::Any values[2] = { SafeAny::Any(first), SafeAny::Any(second) };
+            for (int i=0; ; i++) {
+                child.set( "big", values[i % 2] );
+            }
+        }
+        usleep( 20000 + round * 3000 );
+        kill( pid, SIGKILL );
+        int status = 0;
+        waitpid( pid, &status, 0 );
+
+        // the next writer gets the mutex and repairs the slot left half-written
+        board.set( "num", SafeAny::Any(round) );
+        REQUIRE( board.get("num")->convert<int>() == round );
+
+        // either a complete value or none (discarded by the repair), never a torn one
+        if( const SafeAny::Any* big = board.get("big") )
+        {
+            const std::string str = big->extract<std::string>();
+            REQUIRE( (str == first || str == second) );
+        }
+        board.set( "big", SafeAny::Any(first) );
+        REQUIRE( board.get("big")->extract<std::string>() == first );
+    }
+    BlackboardShm::remove(name);
+}
+
+TEST_CASE( "Image", "Blackboard" )
+{
+    const std::string filename("blackboard_test.img");
+
+    BlackboardImageWriter writer;
+    for (int i=0; i<1000; i++)
+    {
+        writer.set( "param_" + std::to_string(i), i );
+    }
+    writer.set("real", 2.5f);
+    writer.set("str", "hello");
+    REQUIRE_THROWS( writer.set("vect", std::vector<int>(3) ) );
+    writer.save( filename );
+
+    Blackboard bb( std::unique_ptr<BlackboardImage>( new BlackboardImage(filename) ) );
+
+    for (int i=0; i<1000; i++)
+    {
+        int value = -1;
+        REQUIRE( bb.get("param_" + std::to_string(i), value) );
+        REQUIRE( value == i );
+    }
+    double real = 0;
+    std::string str;
+    int num = 0;
+    REQUIRE( bb.get("real", real) );
+    REQUIRE( real == 2.5 );
+    REQUIRE( bb.get("str", str) );
+    REQUIRE( str == "hello" );
+    REQUIRE( !bb.get("param_1000", num) );
+    REQUIRE( !bb.get("missing", num) );
+    REQUIRE_THROWS( bb.set("real", 1.0) );
+
+    // the values are decoded once, also by concurrent readers
+    {
+        BlackboardImage image(filename);
+        std::atomic<int> errors(0);
+        std::vector<std::thread> readers;
+        for (int t=0; t<4; t++)
+        {
+            readers.emplace_back( [&image, &errors]() {
+                for (int i=0; i<1000; i++) {
+                    const SafeAny::Any* value = image.get("param_" + std::to_string(i));
+                    if( !value || value->convert<int>() != i ) { errors++; }
+                }
+            } );
+        }
+        for(auto& reader: readers) { reader.join(); }
+        REQUIRE( errors == 0 );
+    }
+
+    // a string outside of the file is refused at open
+    {
+        std::fstream file( filename, std::ios::in | std::ios::out | std::ios::binary );
+        BlackboardImageFormat::Header header;
+        file.read( reinterpret_cast<char*>(&header), sizeof(header) );
+        for (uint32_t i=0; i<header.count; i++)
+        {
+            BlackboardImageFormat::Entry entry;
+            const std::streamoff pos = header.entries_offset + i*sizeof(entry);
+            file.seekg( pos );
+            file.read( reinterpret_cast<char*>(&entry), sizeof(entry) );
+            if( entry.type == uint8_t(SafeAny::TypeTag::STRING) )
+            {
+                entry.value |= uint64_t(0x7FFFFFFF) << 32;
+                file.seekp( pos );
+                file.write( reinterpret_cast<const char*>(&entry), sizeof(entry) );
+            }
+        }
+    }
+    REQUIRE_THROWS_AS( BlackboardImage(filename), std::runtime_error );
+
+    // so is a displacement pointing outside of the entries
+    writer.save( filename );
+    {
+        std::fstream file( filename, std::ios::in | std::ios::out | std::ios::binary );
+        BlackboardImageFormat::Header header;
+        file.read( reinterpret_cast<char*>(&header), sizeof(header) );
+        const int32_t displacement = std::numeric_limits<int32_t>::min();
+        file.seekp( header.displacement_offset );
+        file.write( reinterpret_cast<const char*>(&displacement), sizeof(displacement) );
+    }
+    REQUIRE_THROWS_AS( BlackboardImage(filename), std::runtime_error );
+
+    std::remove( filename.c_str() );
+}
+
+TEST_CASE( "BasicBlackboard", "Blackboard" )
+{
+    BasicBlackboard<BlackboardLocal> bb;
+
+    int num = 0;
+    std::string str;
+
+    REQUIRE( !bb.get("num", num) );
+    bb.set("num", 42);
+    bb.set("str", "hello");
+
+    REQUIRE( bb.get("num", num) );
+    REQUIRE( num == 42 );
+    REQUIRE( bb.get("str", str) );
+    REQUIRE( str == "hello" );
+    REQUIRE( bb.implementation().get("num") != nullptr );
+}
+
+TEST_CASE( "Concurrent", "Blackboard" )
+{
+    Blackboard bb( std::unique_ptr<BlackboardConcurrent>( new BlackboardConcurrent(4) ) );
+
+    double x = 0, y = 0;
+    int64_t stamp = 0;
+    std::string name;
+
+    REQUIRE( !bb.getMany( {"x", "y", "stamp"}, x, y, stamp ) );
+
+    bb.setMany( {"x", "y", "stamp", "name"}, 1.5, 2.5, 100, "robot" );
+    REQUIRE( bb.getMany( {"x", "y", "stamp", "name"}, x, y, stamp, name ) );
+    REQUIRE( x == 1.5 );
+    REQUIRE( y == 2.5 );
+    REQUIRE( stamp == 100 );
+    REQUIRE( name == "robot" );
+
+    // the values of the keys found are written also when others are missing
+    x = 0;
+    REQUIRE( !bb.getMany( {"x", "missing"}, x, y ) );
+    REQUIRE( x == 1.5 );
+
+    // more keys than the shards, and more than the local buffers
+    std::vector<std::string> keys;
+    std::vector<SafeAny::Any> values;
+    for(int i=0; i<100; i++)
+    {
+        keys.push_back( "key_" + std::to_string(i) );
+        values.push_back( SafeAny::Any(i) );
+    }
+    BlackboardConcurrent backend(4);
+    backend.setMany( keys.data(), values.data(), keys.size() );
+
+    std::vector<SafeAny::Any> read( keys.size() );
+    std::unique_ptr<bool[]> found( new bool[keys.size()] );
+    backend.getMany( keys.data(), keys.size(), read.data(), found.get() );
+    for(int i=0; i<100; i++)
+    {
+        REQUIRE( found[i] );
+        REQUIRE( read[i].convert<int>() == i );
+    }
+
+    std::vector<std::thread> threads;
+    for(int t=0; t<4; t++)
+    {
+        threads.emplace_back( [&bb, t]()
+        {
+            const std::string a = "a_" + std::to_string(t);
+            const std::string b = "b_" + std::to_string(t);
+            for(int i=0; i<1000; i++)
+            {
+                bb.setMany( {a, b}, i, -i );
+                int va = 0, vb = 0;
+                bb.getMany( {a, b}, va, vb );
+                if( va != i || vb != -i ) { throw std::runtime_error("wrong value"); }
+            }
+        } );
+    }
+    for(auto& th: threads) { th.join(); }
+
+    int last = 0;
+    REQUIRE( bb.get("a_3", last) );
+    REQUIRE( last == 999 );
+}
+
+TEST_CASE( "LocalBatch", "Blackboard" )
+{
+    // default implementation of the batch methods
+    BasicBlackboard<BlackboardLocal> bb;
+    bb.setMany( {"num", "str"}, 42, std::string("hello") );
+
+    int num = 0;
+    std::string str;
+    REQUIRE( bb.getMany( {"num", "str"}, num, str ) );
+    REQUIRE( num == 42 );
+    REQUIRE( str == "hello" );
+}
+
+TEST_CASE( "Transaction", "Blackboard" )
+{
+    Blackboard bb( std::unique_ptr<BlackboardConcurrent>( new BlackboardConcurrent(4) ) );
+    bb.setMany( {"a", "b"}, 0, 0 );
+
+    // reads its own writes, nothing is visible before the commit
+    bb.transaction( [&](BlackboardTransaction& tx)
+    {
+        int a = -1;
+        REQUIRE( tx.get("a", a) );
+        tx.set("a", a + 10);
+        REQUIRE( tx.get("a", a) );
+        REQUIRE( a == 10 );
+        REQUIRE( !tx.get("missing", a) );
+
+        int outside = -1;
+        bb.get("a", outside);
+        REQUIRE( outside == 0 );
+    } );
+    int a = 0;
+    REQUIRE( bb.get("a", a) );
+    REQUIRE( a == 10 );
+
+    // a conflicting write makes the commit fail
+    BlackboardConcurrent concurrent;
+    concurrent.set("x", 1);
+    BlackboardTransaction tx( concurrent );
+    tx.begin();
+    int x = 0;
+    REQUIRE( tx.get("x", x) );
+    concurrent.set("x", 2);
+    tx.set("x", x + 1);
+    REQUIRE( !tx.commit() );
+
+    // and a read of an entry newer than the snapshot throws Conflict
+    tx.begin();
+    concurrent.set("y", 1);
+    REQUIRE( tx.get("x", x) );
+    concurrent.set("x", 3);
+    REQUIRE_THROWS_AS( tx.get("y", x), BlackboardTransaction::Conflict );
+
+    // concurrent increments are never lost, readers always see a == b
+    bb.setMany( {"a", "b"}, 0, 0 );
+    std::atomic<int> inconsistent(0);
+    std::vector<std::thread> threads;
+    for(int t=0; t<4; t++)
+    {
+        threads.emplace_back( [&bb, &inconsistent]()
+        {
+            for(int i=0; i<500; i++)
+            {
+                bb.transaction( [](BlackboardTransaction& tx)
+                {
+                    int a = 0, b = 0;
+                    tx.getMany( {"a", "b"}, a, b );
+                    tx.setMany( {"a", "b"}, a + 1, b + 1 );
+                } );
+                bb.transaction( [&inconsistent](BlackboardTransaction& tx)
+                {
+                    int a = 0, b = 0;
+                    tx.getMany( {"a", "b"}, a, b );
+                    if( a != b ) { inconsistent++; }
+                } );
+            }
+        } );
+    }
+    for(auto& th: threads) { th.join(); }
+
+    int b = 0;
+    REQUIRE( bb.getMany( {"a", "b"}, a, b ) );
+    REQUIRE( a == 2000 );
+    REQUIRE( b == 2000 );
+    REQUIRE( inconsistent == 0 );
+
+    // backends without versions execute the transaction once
+    BasicBlackboard<BlackboardLocal> local;
+    int calls = 0;
+    local.transaction( [&calls](BlackboardTransaction& tx)
+    {
+        calls++;
+        tx.setMany( {"a", "b"}, 1, 2 );
+    } );
+    REQUIRE( calls == 1 );
+    REQUIRE( local.getMany( {"a", "b"}, a, b ) );
+    REQUIRE( a + b == 3 );
+}
+
+TEST_CASE( "MoveOnly", "Blackboard" )
+{
+    struct PointCloud
+    {
+        std::vector<float> points;
+    };
+
+    Blackboard bb( std::unique_ptr<BlackboardLocal>( new BlackboardLocal ) );
+
+    std::unique_ptr<PointCloud> cloud( new PointCloud{ std::vector<float>(1000, 1.0f) } );
+    const float* points = cloud->points.data();
+    bb.set("cloud", std::move(cloud));
+
+    // no copies: the same buffer
+    const std::unique_ptr<PointCloud>* stored = bb.getPtr<std::unique_ptr<PointCloud>>("cloud");
+    REQUIRE( stored != nullptr );
+    REQUIRE( (*stored)->points.data() == points );
+    REQUIRE( bb.getPtr<int>("cloud") == nullptr );
+
+    // replaced by another move-only value
+    bb.set("cloud", std::unique_ptr<PointCloud>( new PointCloud{ std::vector<float>(10, 2.0f) } ));
+    REQUIRE( (*bb.getPtr<std::unique_ptr<PointCloud>>("cloud"))->points.size() == 10 );
+
+    // the value can't be copied out of the blackboard
+    SafeAny::Any copy;
+    BlackboardLocal local;
+    local.set("cloud", SafeAny::Any( std::unique_ptr<PointCloud>( new PointCloud ) ));
+    REQUIRE_THROWS_AS( copy = *local.get("cloud"), linb::bad_any_copy );
+
+    // rvalues of copyable types are moved too
+    std::vector<double> vect(100, 1.0);
+    const double* data = vect.data();
+    bb.set("vect", std::move(vect));
+    REQUIRE( bb.getPtr<std::vector<double>>("vect")->data() == data );
+}
+
+TEST_CASE( "SharedValues", "Blackboard" )
+{
+    std::unique_ptr<BlackboardConcurrent> backend( new BlackboardConcurrent(4) );
+    Blackboard bb( std::move(backend) );
+
+    const std::vector<double> map(10000, 0.5);
+    bb.set( "map", SafeAny::Any::makeShared(map) );
+
+    // get() returns a copy of the Any, which refers to the same vector
+    const std::vector<double>* first = bb.getPtr<std::vector<double>>("map");
+    const std::vector<double>* second = bb.getPtr<std::vector<double>>("map");
+    REQUIRE( first->data() == second->data() );
+    std::vector<double> value;
+    REQUIRE( bb.get("map", value) );
+    REQUIRE( value == map );
+
+    // a plain value replaces the shared one
+    bb.set( "map", std::vector<double>(3, 1.0) );
+    REQUIRE( bb.get("map", value) );
+    REQUIRE( value.size() == 3 );
+
+    // also in BlackboardLocal, where the vector can't be assigned in place
+    std::unique_ptr<BlackboardLocal> local_backend( new BlackboardLocal );
+    BlackboardLocal& local = *local_backend;
+    Blackboard local_bb( std::move(local_backend) );
+    local_bb.set( "map", SafeAny::Any::makeShared(map) );
+    REQUIRE( local.get("map")->isShared() );
+    local_bb.set( "map", std::vector<double>(3, 1.0) );
+    REQUIRE( !local.get("map")->isShared() );
+    REQUIRE( local_bb.get("map", value) );
+    REQUIRE( value.size() == 3 );
+}
+
+namespace{
+struct Pose { double x, y; };
+}
+
+TEST_CASE( "Variant", "Blackboard" )
+{
+    using SafeAny::ConversionError;
+    typedef BlackboardVariant<double, int32_t, uint8_t, std::string, std::vector<float>, Pose> Board;
+
+    Board bb;
+    bb.set("speed", int32_t(300));
+    bb.set("name", "robot");
+    bb.set("pose", Pose{1.0, 2.0});
+    bb.set("ranges", std::vector<float>(3, 0.5f));
+
+    // same rules of SafeAny::Any
+    double real = 0;
+    uint8_t small = 7;
+    std::string str;
+    REQUIRE( bb.get("speed", real) );
+    REQUIRE( real == 300.0 );
+    REQUIRE( bb.tryGet("speed", small) == ConversionError::TooLarge );
+    REQUIRE( small == 7 );
+    REQUIRE( bb.tryGet("name", real) == ConversionError::StringToNumber );
+    REQUIRE( bb.tryGet("pose", str) == ConversionError::NotAString );
+    REQUIRE( bb.tryGet("pose", real) == ConversionError::TypeMismatch );
+    REQUIRE( bb.tryGet("missing", real) == ConversionError::MissingKey );
+    REQUIRE( bb.get("speed", str) );
+    REQUIRE( str == "300" );
+    std::vector<double> ranges;
+    REQUIRE( bb.get("ranges", ranges) );
+    REQUIRE( ranges == std::vector<double>(3, 0.5) );
+    REQUIRE( bb.getPtr<Pose>("pose")->y == 2.0 );
+    REQUIRE_THROWS_AS( bb.get("speed", small), std::runtime_error );
+
+    // the type of a key can change, strings are assigned in place
+    bb.set("speed", 1.5);
+    REQUIRE( bb.getVariant("speed")->holds<double>() );
+    const char* data = bb.getPtr<std::string>("name")->data();
+    bb.set("name", std::string("r2"));
+    REQUIRE( bb.getPtr<std::string>("name")->data() == data );
+
+    // SafeAny::Variant
+    SafeAny::Variant<int8_t, std::string> variant;
+    REQUIRE( variant.holds<int8_t>() );
+    variant.set( std::string("hello") );
+    SafeAny::Variant<int8_t, std::string> copy( variant );
+    variant = SafeAny::Variant<int8_t, std::string>( int8_t(-1) );
+    REQUIRE( copy.convert<std::string>() == "hello" );
+    REQUIRE( variant.convert<int>() == -1 );
+    REQUIRE( variant.tryConvert(small) == ConversionError::Negative );
+
+    // front-end of the type-erased Blackboard
+    Blackboard board( std::unique_ptr<Board>( new Board ) );
+    board.set("count", int32_t(5));
+    board.set("label", "hello");
+    int count = 0;
+    REQUIRE( board.get("count", count) );
+    REQUIRE( count == 5 );
+    REQUIRE( board.get("label", str) );
+    REQUIRE( str == "hello" );
+    board.set("count", 2.5);
+    REQUIRE( board.get("count", real) );
+    REQUIRE( real == 2.5 );
+    REQUIRE_THROWS_AS( board.set("count", int64_t(1)), std::runtime_error );
+}
+
+TEST_CASE( "Compact", "Blackboard" )
+{
+    using SafeAny::ConversionError;
+    using SafeAny::CompactAny;
+
+    REQUIRE( sizeof(CompactAny) == 16 );
+    CompactAny number( int16_t(-3) );
+    REQUIRE( number.isNumber() );
+    REQUIRE( number.typeId() == linb::detail::type_id<int16_t>() );
+    uint8_t small = 7;
+    REQUIRE( number.tryConvert(small) == ConversionError::Negative );
+    CompactAny text( SafeAny::Any( std::string("hello") ) );
+    CompactAny copy( text );
+    REQUIRE( copy.boxed() != text.boxed() );
+    std::string str;
+    REQUIRE( copy.tryConvert(str) == ConversionError::Ok );
+    REQUIRE( str == "hello" );
+    copy = number;
+    REQUIRE( copy.number().convert<int>() == -3 );
+    REQUIRE( CompactAny().empty() );
+
+    // many keys, rehashed while growing
+    BlackboardCompact compact;
+    for (int i=0; i<5000; i++) {
+        compact.set( "cell_" + std::to_string(i), float(i) );
+    }
+    compact.set( "name", SafeAny::Any( std::string("grid") ) );
+    compact.set( "cell_1", 1.5 );
+    REQUIRE( compact.size() == 5001 );
+    for (int i=2; i<5000; i++)
+    {
+        int value = -1;
+        REQUIRE( compact.get( "cell_" + std::to_string(i), value ) );
+        REQUIRE( value == i );
+    }
+    double real = 0;
+    REQUIRE( compact.get("cell_1", real) );
+    REQUIRE( real == 1.5 );
+    REQUIRE( compact.tryGet("missing", real) == ConversionError::MissingKey );
+    REQUIRE( compact.tryGet("name", real) == ConversionError::StringToNumber );
+
+    // front-end of the type-erased Blackboard
+    Blackboard bb( std::unique_ptr<BlackboardCompact>( new BlackboardCompact(100) ) );
+    bb.set("count", int32_t(5));
+    bb.set("label", "hello");
+    bb.set("ranges", std::vector<double>(3, 1.0));
+    int count = 0;
+    std::vector<double> ranges;
+    REQUIRE( bb.get("count", count) );
+    REQUIRE( count == 5 );
+    REQUIRE( bb.get("label", str) );
+    REQUIRE( str == "hello" );
+    REQUIRE( bb.get("ranges", ranges) );
+    REQUIRE( ranges.size() == 3 );
+    bb.set("label", 2.5);
+    REQUIRE( bb.get("label", real) );
+    REQUIRE( real == 2.5 );
+    REQUIRE( !bb.get("missing", real) );
+}
@@ -0,0 +1,35 @@
+// Compiled with -fno-exceptions: the conversion engine must build and report
+// its errors through tryConvert().
+#include <cstdio>
+#include <vector>
+#include "SafeAny/safe_any.hpp"
+
+using SafeAny::Any;
+using SafeAny::ConversionError;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if( !(condition) ) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; }
+
+int main()
+{
+    uint8_t small = 0;
+    CHECK( Any(int(250)).tryConvert(small) == ConversionError::Ok );
+    CHECK( small == 250 );
+    CHECK( Any(int(300)).tryConvert(small) == ConversionError::TooLarge );
+    CHECK( Any(double(-1.0)).tryConvert(small) == ConversionError::Negative );
+    CHECK( Any(std::string("1")).tryConvert(small) == ConversionError::StringToNumber );
+
+    std::string str;
+    CHECK( Any(int(42)).tryConvert(str) == ConversionError::Ok );
+    CHECK( str == "42" );
+
+    Any copy = Any::makeShared( std::vector<double>(100, 1.0) );
+    std::vector<double> vect;
+    CHECK( copy.tryConvert(vect) == ConversionError::Ok );
+    CHECK( vect.size() == 100 );
+
+    if( failures == 0 ) { printf("All checks passed\n"); }
+    return failures == 0 ? 0 : 1;
+}
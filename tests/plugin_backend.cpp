@@ -0,0 +1,19 @@
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_plugin.h"
+#include "plugin_backend.h"
+
+// Test plugin: the values of the backend "defaults" are created inside this library.
+
+BLACKBOARD_PLUGIN_ENTRY_POINT(registry)
+{
+    registry.add<BlackboardLocal>("local");
+
+    registry.add("defaults", [](const std::string& params) -> BlackboardImpl*
+    {
+        BlackboardLocal* bb = new BlackboardLocal();
+        bb->set("params", SafeAny::Any(params) );
+        bb->set("point", SafeAny::Any( PluginPoint{1.0, 2.0} ) );
+        bb->set("number", SafeAny::Any( int16_t(42) ) );
+        return bb;
+    });
+}
@@ -0,0 +1,12 @@
+#ifndef PLUGIN_BACKEND_H
+#define PLUGIN_BACKEND_H
+
+// Type shared by the test and the test plugin. The plugin is compiled with
+// -fvisibility=hidden, therefore it has its own copy of the type_info.
+struct PluginPoint
+{
+    double x;
+    double y;
+};
+
+#endif // PLUGIN_BACKEND_H
@@ -0,0 +1,11 @@
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_plugin.h"
+
+// Test plugin registering a new backend and one with the name of a backend of
+// tests/plugin_backend.cpp: neither of them must be registered.
+
+BLACKBOARD_PLUGIN_ENTRY_POINT(registry)
+{
+    registry.add<BlackboardLocal>("conflict_local");
+    registry.add<BlackboardLocal>("local");
+}
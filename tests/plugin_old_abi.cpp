@@ -0,0 +1,15 @@
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/blackboard_plugin.h"
+
+// Test plugin built for an older ABI: BlackboardPluginLoader must refuse it.
+
+extern "C" __attribute__((visibility("default"))) int blackboard_plugin_abi_version()
+{
+    return BLACKBOARD_PLUGIN_ABI_VERSION - 1;
+}
+
+extern "C" __attribute__((visibility("default")))
+void blackboard_plugin_register(BlackboardPluginRegistry& registry)
+{
+    registry.add<BlackboardLocal>("old_local");
+}
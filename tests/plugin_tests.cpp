@@ -0,0 +1,42 @@
+#include "catch.hpp"
+#include "Blackboard/blackboard_plugin.h"
+#include "plugin_backend.h"
+
+TEST_CASE( "Plugins", "Blackboard" )
+{
+    BlackboardPluginLoader loader;
+    // the plugin built for another ABI version is skipped
+    std::vector<std::string> errors;
+    REQUIRE( loader.loadDirectory(BLACKBOARD_TEST_PLUGIN_DIR, &errors) == 1 );
+    REQUIRE( errors.size() == 1 );
+    REQUIRE( errors[0].find("ABI") != std::string::npos );
+    REQUIRE( loader.contains("local") );
+    REQUIRE( loader.contains("defaults") );
+    REQUIRE( !loader.contains("old_local") );
+    REQUIRE_THROWS( loader.create("missing") );
+    REQUIRE_THROWS( loader.load("not_a_plugin.so") );
+
+    // "local" is already registered: "conflict_local" is not registered either
+    REQUIRE_THROWS( loader.load(BLACKBOARD_TEST_CONFLICT_PLUGIN) );
+    REQUIRE( !loader.contains("conflict_local") );
+    REQUIRE( loader.libraries().size() == 1 );
+
+    Blackboard local( loader.create("local") );
+    local.set("num", 7);
+    int num = 0;
+    REQUIRE( local.get("num", num) );
+    REQUIRE( num == 7 );
+
+    // values created by the plugin
+    Blackboard defaults( loader.create("defaults", "hello") );
+    std::string params;
+    PluginPoint point = {0, 0};
+    double number = 0;
+    REQUIRE( defaults.get("params", params) );
+    REQUIRE( params == "hello" );
+    REQUIRE( defaults.get("point", point) );
+    REQUIRE( point.x == 1.0 );
+    REQUIRE( point.y == 2.0 );
+    REQUIRE( defaults.get("number", number) );
+    REQUIRE( number == 42.0 );
+}
@@ -0,0 +1,155 @@
+#include "catch.hpp"
+#include "Blackboard/blackboard_local.h"
+#include "Blackboard/allocation_monitor.h"
+
+BLACKBOARD_ALLOCATION_MONITOR_HOOKS
+
+static std::size_t reported = 0;
+
+static void countReported(std::size_t) { reported++; }
+
+TEST_CASE( "AllocationMonitor", "RealTime" )
+{
+    REQUIRE( AllocationMonitor::enabled() );
+
+    AllocationMonitor::setHandler( countReported );
+    reported = 0;
+    {
+        AllocationMonitor::Section section;
+        std::unique_ptr<std::string> str( new std::string(100, 'x') );
+        REQUIRE( section.allocations() == 2 );
+    }
+    // outside of a section the allocations are counted, but not reported
+    std::unique_ptr<int> num( new int(1) );
+    AllocationMonitor::setHandler( nullptr );
+    REQUIRE( reported == 2 );
+}
+
+TEST_CASE( "TickLoop", "RealTime" )
+{
+    std::unique_ptr<BlackboardLocal> backend( new BlackboardLocal );
+    BlackboardLocal* local = backend.get();
+    Blackboard bb( std::move(backend) );
+
+    const std::string X("pose_x"), COUNT("count"), MODE("mode"), RANGES("ranges");
+
+    // setup: all the keys, values as large as they will ever be
+    local->reserve(16);
+    bb.set(X, 0.0);
+    bb.set(COUNT, 0);
+    bb.set(MODE, std::string(32, ' '));
+    bb.set(RANGES, std::vector<double>(360));
+    local->setRealTime(true);
+
+    const std::string modes[] = { "idle", "moving to the goal" };
+    std::vector<double> ranges(360, 0.0), ranges_out;
+    std::string mode_out;
+    ranges_out.reserve(360);
+    mode_out.reserve(32);
+    double x_out = 0;
+    int count_out = 0;
+    bool all_found = true;
+
+    std::size_t allocations = 0;
+    {
+        AllocationMonitor::Section section;
+        for(int tick=0; tick<1000; tick++)
+        {
+            ranges[tick % 360] = tick;
+            bb.set(X, tick * 0.5);
+            bb.set(COUNT, tick);
+            bb.set(MODE, modes[tick % 2]);
+            bb.set(RANGES, ranges);
+            if( tick % 10 == 0 ) {
+                bb.set(COUNT, double(tick));  // numbers can change type
+            }
+
+            all_found &= bb.get(X, x_out);
+            all_found &= bb.get(COUNT, count_out);
+            all_found &= bb.get(MODE, mode_out);
+            all_found &= bb.get(RANGES, ranges_out);
+        }
+        allocations = section.allocations();
+    }
+
+    REQUIRE( allocations == 0 );
+    REQUIRE( all_found );
+    REQUIRE( x_out == 999 * 0.5 );
+    REQUIRE( count_out == 999 );
+    REQUIRE( mode_out == modes[1] );
+    REQUIRE( ranges_out == ranges );
+
+    // the operations that would allocate are refused
+    REQUIRE_THROWS( bb.set("new_key", 1) );
+    REQUIRE_THROWS( bb.set(X, std::vector<int>(3)) );
+
+    local->setRealTime(false);
+    bb.set("new_key", 1);
+    REQUIRE( bb.get("new_key", count_out) );
+}
+
+TEST_CASE( "InPlaceAssignment", "RealTime" )
+{
+    std::unique_ptr<BlackboardLocal> backend( new BlackboardLocal );
+    BlackboardLocal* local = backend.get();
+    Blackboard bb( std::move(backend) );
+
+    std::vector<double> vect(1000, 1.0);
+    bb.set("vect", vect);
+    const double* buffer = local->get("vect")->extractPtr<std::vector<double>>()->data();
+
+    // same type: the vector stored is assigned, its buffer reused
+    std::size_t allocations = 0;
+    {
+        AllocationMonitor::Section section;
+        for(int i=0; i<100; i++)
+        {
+            vect[i] = i;
+            bb.set("vect", vect);
+        }
+        allocations = section.allocations();
+    }
+    REQUIRE( allocations == 0 );
+    REQUIRE( local->get("vect")->extractPtr<std::vector<double>>()->data() == buffer );
+
+    // also through the type-erased API of the backend
+    const SafeAny::Any value( std::vector<double>(500, 2.0) );
+    {
+        AllocationMonitor::Section section;
+        local->set("vect", value);
+        allocations = section.allocations();
+    }
+    REQUIRE( allocations == 0 );
+    std::vector<double> out;
+    REQUIRE( bb.get("vect", out) );
+    REQUIRE( out == std::vector<double>(500, 2.0) );
+
+    // a different type replaces the value
+    bb.set("vect", 42);
+    int num = 0;
+    REQUIRE( bb.get("vect", num) );
+    REQUIRE( num == 42 );
+
+    // strings reuse their buffer too
+    bb.set("str", std::string(100, 'a'));
+    {
+        AllocationMonitor::Section section;
+        bb.set("str", "shorter");
+        allocations = section.allocations();
+    }
+    REQUIRE( allocations == 0 );
+    std::string str;
+    REQUIRE( bb.get("str", str) );
+    REQUIRE( str == "shorter" );
+
+    // emplace
+    bb.emplace<std::vector<double>>("ranges", 360, 0.5);
+    REQUIRE( bb.get("ranges", out) );
+    REQUIRE( out == std::vector<double>(360, 0.5) );
+    bb.emplace<std::vector<double>>("ranges", 10, 1.5);
+    REQUIRE( bb.get("ranges", out) );
+    REQUIRE( out == std::vector<double>(10, 1.5) );
+    bb.emplace<std::string>("str", 5, 'x');
+    REQUIRE( bb.get("str", str) );
+    REQUIRE( str == "xxxxx" );
+}
@@ -0,0 +1,41 @@
+#include "catch.hpp"
+#include "Blackboard/blackboard_sqlite.h"
+
+TEST_CASE( "Sqlite", "Blackboard" )
+{
+    const std::string filename("blackboard_test.db");
+    std::remove( filename.c_str() );
+    {
+        BlackboardSqlite* impl = new BlackboardSqlite(filename, 4);
+        Blackboard bb( (std::unique_ptr<BlackboardSqlite>(impl)) );
+
+        for (int i=0; i<10; i++)
+        {
+            bb.set("num_" + std::to_string(i), i);
+        }
+        bb.set("str", "hello");
+        REQUIRE( impl->pendingChanges() == 3 );
+        REQUIRE_THROWS( bb.set("vect", std::vector<int>(3)) );
+
+        int num = 0;
+        REQUIRE( bb.get("num_3", num) );
+        REQUIRE( num == 3 );
+        bb.set("num_3", 33);
+        // destructor flushes
+    }
+    {
+        Blackboard bb( std::unique_ptr<BlackboardSqlite>( new BlackboardSqlite(filename) ) );
+        int num = 0;
+        std::string str;
+        REQUIRE( bb.get("num_9", num) );
+        REQUIRE( num == 9 );
+        REQUIRE( bb.get("num_3", num) );
+        REQUIRE( num == 33 );
+        REQUIRE( bb.get("str", str) );
+        REQUIRE( str == "hello" );
+        REQUIRE( !bb.get("missing", num) );
+    }
+    for(const std::string suffix: {"", "-wal", "-shm"}){
+        std::remove( (filename + suffix).c_str() );
+    }
+}
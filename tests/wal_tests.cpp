@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "Blackboard/blackboard_wal.h"
+#include "Blackboard/blackboard_async_log.h"
+
+static void removeWalFiles(const std::string& filename)
+{
+    std::remove( (filename + ".log").c_str() );
+    std::remove( (filename + ".snapshot").c_str() );
+}
+
+TEST_CASE( "WriteAheadLog", "Blackboard" )
+{
+    const std::string filename("blackboard_test_wal");
+    removeWalFiles(filename);
+    {
+        BlackboardWal bb(filename);
+
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; t++)
+        {
+            threads.emplace_back( [&bb, t]()
+            {
+                for (int i=0; i<50; i++){
+                    bb.set( "num_" + std::to_string(t*100 + i), SafeAny::Any(i) );
+                }
+            });
+        }
+        for(auto& th: threads) { th.join(); }
+
+        bb.set("str", SafeAny::Any(std::string("hello")) );
+        bb.compact();
+        REQUIRE( bb.logSize() == 0 );
+        bb.set("str", SafeAny::Any(std::string("world")) );
+        bb.set("tail", SafeAny::Any(42) );
+        REQUIRE_THROWS( bb.set("vect", SafeAny::Any( std::vector<int>(3) )) );
+    }
+    {
+        // simulate a crash in the middle of a write
+        FILE* log = fopen( (filename + ".log").c_str(), "ab" );
+        fwrite( "\x20\x00\x00\x00garbage", 1, 11, log );
+        fclose(log);
+    }
+    {
+        Blackboard bb( std::unique_ptr<BlackboardWal>( new BlackboardWal(filename) ) );
+        int num = 0;
+        std::string str;
+        REQUIRE( bb.get("num_349", num) );
+        REQUIRE( num == 49 );
+        REQUIRE( bb.get("tail", num) );
+        REQUIRE( num == 42 );
+        REQUIRE( bb.get("str", str) );
+        REQUIRE( str == "world" );
+        REQUIRE( !bb.get("num_50", num) );
+    }
+    removeWalFiles(filename);
+}
+
+TEST_CASE( "WalGetCopies", "Blackboard" )
+{
+    removeWalFiles("blackboard_test_wal_a");
+    removeWalFiles("blackboard_test_wal_b");
+    {
+        BlackboardWal wal_a("blackboard_test_wal_a", false);
+        BlackboardWal wal_b("blackboard_test_wal_b", false);
+        wal_a.set( "x", SafeAny::Any(1) );
+        wal_b.set( "y", SafeAny::Any(2) );
+
+        // the copy returned by a blackboard is not overwritten by the other one
+        const SafeAny::Any* x = wal_a.get("x");
+        const SafeAny::Any* y = wal_b.get("y");
+        REQUIRE( x->convert<int>() == 1 );
+        REQUIRE( y->convert<int>() == 2 );
+    }
+    removeWalFiles("blackboard_test_wal_a");
+    removeWalFiles("blackboard_test_wal_b");
+}
+
+TEST_CASE( "AsyncLog", "Blackboard" )
+{
+    const std::string filename("blackboard_test_async");
+    removeWalFiles(filename);
+
+    for(bool use_io_uring: {true, false})
+    {
+        {
+            BlackboardAsyncLog bb(filename, 4096, use_io_uring);
+            for (int i=0; i<1000; i++){
+                bb.set( "num_" + std::to_string(i % 10), SafeAny::Any(i) );
+            }
+            bb.set("str", SafeAny::Any(std::string("hello")) );
+            bb.flush();
+        }
+        {
+            // same format of BlackboardWal
+            Blackboard bb( std::unique_ptr<BlackboardWal>( new BlackboardWal(filename) ) );
+            int num = 0;
+            std::string str;
+            REQUIRE( bb.get("num_9", num) );
+            REQUIRE( num == 999 );
+            REQUIRE( bb.get("str", str) );
+            REQUIRE( str == "hello" );
+        }
+        {
+            BlackboardAsyncLog bb(filename, 4096, use_io_uring);
+            const SafeAny::Any* value = bb.get("num_3");
+            REQUIRE( value );
+            REQUIRE( value->convert<int>() == 993 );
+        }
+        removeWalFiles(filename);
+    }
+}
+
+TEST_CASE( "AsyncLogError", "Blackboard" )
+{
+    // every write to /dev/full fails with ENOSPC
+    const std::string filename("blackboard_test_async_full");
+    removeWalFiles(filename);
+    REQUIRE( symlink( "/dev/full", (filename + ".log").c_str() ) == 0 );
+
+    for(bool use_io_uring: {true, false})
+    {
+        BlackboardAsyncLog bb(filename, 4096, use_io_uring);
+        bb.set( "num", SafeAny::Any(42) );
+        REQUIRE_THROWS_AS( bb.flush(), std::runtime_error );
+        // the error is sticky
+        REQUIRE_THROWS_AS( bb.flush(), std::runtime_error );
+        REQUIRE_THROWS_AS( bb.set( "num", SafeAny::Any(43) ), std::runtime_error );
+    }
+    removeWalFiles(filename);
+}